@@ -0,0 +1,294 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Choosing a justifier from the features of a paragraph. See
+   autojust.h. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "autojust.h"
+#include "hqjust.h"
+#include "hsjust.h"
+
+/* The defaults, from justtune on an x86-64 machine. hnj_hs_just
+   found the same result as hnj_hq_just, several times faster, for
+   paragraphs that fit on a line, and a worse one from two lines on.
+   There was one processor, so threads never paid; whether they do
+   elsewhere is left to hnj_hq_just. */
+#define DEFAULT_GREEDY_MAX_LINES 1
+#define DEFAULT_PARALLEL_MIN_BREAKS 0
+
+static HnjJustProfile env_profile;
+
+#ifdef HAVE_PTHREAD
+static pthread_once_t env_profile_once = PTHREAD_ONCE_INIT;
+#else
+static int env_profile_loaded;
+#endif
+
+void
+hnj_just_profile_init (HnjJustProfile *profile)
+{
+  profile->greedy_max_lines = DEFAULT_GREEDY_MAX_LINES;
+  profile->parallel_min_breaks = DEFAULT_PARALLEL_MIN_BREAKS;
+  profile->greedy_min_breaks = 0;
+  profile->anytime_max_usec = 0;
+}
+
+/* The fields of the profile file. */
+static int *
+profile_field (HnjJustProfile *profile, const char *name)
+{
+  if (!strcmp (name, "greedy_max_lines"))
+    return &profile->greedy_max_lines;
+  if (!strcmp (name, "parallel_min_breaks"))
+    return &profile->parallel_min_breaks;
+  if (!strcmp (name, "greedy_min_breaks"))
+    return &profile->greedy_min_breaks;
+  if (!strcmp (name, "anytime_max_usec"))
+    return &profile->anytime_max_usec;
+  return NULL;
+}
+
+int
+hnj_just_profile_load (HnjJustProfile *profile, const char *filename)
+{
+  FILE *file;
+  char line[256];
+  char name[64];
+  int value;
+  int *field;
+  int status = 0;
+
+  file = fopen (filename, "r");
+  if (file == NULL)
+    return -1;
+  while (fgets (line, sizeof (line), file))
+    {
+      if (line[0] == '#' || line[strspn (line, " \t\r\n")] == '\0')
+	continue;
+      if (sscanf (line, "%63s %d", name, &value) != 2 ||
+	  (field = profile_field (profile, name)) == NULL)
+	{
+	  status = -1;
+	  break;
+	}
+      *field = value;
+    }
+  fclose (file);
+  return status;
+}
+
+int
+hnj_just_profile_save (const HnjJustProfile *profile, const char *filename)
+{
+  FILE *file;
+
+  file = fopen (filename, "w");
+  if (file == NULL)
+    return -1;
+  fprintf (file, "# libjustify profile\n");
+  fprintf (file, "greedy_max_lines %d\n", profile->greedy_max_lines);
+  fprintf (file, "parallel_min_breaks %d\n", profile->parallel_min_breaks);
+  fprintf (file, "greedy_min_breaks %d\n", profile->greedy_min_breaks);
+  fprintf (file, "anytime_max_usec %d\n", profile->anytime_max_usec);
+  return fclose (file) ? -1 : 0;
+}
+
+static void
+load_env_profile (void)
+{
+  const char *filename = getenv ("LIBJUSTIFY_PROFILE");
+
+  hnj_just_profile_init (&env_profile);
+  if (filename && *filename &&
+      hnj_just_profile_load (&env_profile, filename))
+    {
+      fprintf (stderr, "libjustify: can't load profile %s\n", filename);
+      hnj_just_profile_init (&env_profile);
+    }
+}
+
+static const HnjJustProfile *
+get_env_profile (void)
+{
+#ifdef HAVE_PTHREAD
+  pthread_once (&env_profile_once, load_env_profile);
+#else
+  if (!env_profile_loaded)
+    {
+      env_profile_loaded = 1;
+      load_env_profile ();
+    }
+#endif
+  return &env_profile;
+}
+
+void
+hnj_just_features (const HnjBreak *breaks, int n_breaks,
+		   const HnjParams *params, HnjJustFeatures *features)
+{
+  int n_spaces = 0;
+  int n_hyphens = 0;
+  int n_hard = 0;
+  int width;
+  int i;
+
+  features->n_breaks = n_breaks;
+  features->has_tabs = 0;
+  for (i = 0; i < n_breaks; i++)
+    {
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISSPACE)
+	n_spaces++;
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISHYPHEN)
+	n_hyphens++;
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISTAB)
+	features->has_tabs = 1;
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISHARD)
+	n_hard++;
+    }
+  features->hyphens = n_breaks ? n_hyphens * 1000LL / n_breaks : 0;
+
+  width = n_breaks ? breaks[n_breaks - 1].x0 : 0;
+  if (params->set_width > 0 && width > 0)
+    {
+      features->n_lines = (width + params->set_width - 1LL) /
+	params->set_width + n_hard;
+      features->line_words = (long long) params->set_width *
+	(n_spaces + 1) / width;
+    }
+  else
+    {
+      features->n_lines = n_breaks;
+      features->line_words = 0;
+    }
+}
+
+int
+hnj_just_choose (const HnjJustFeatures *features,
+		 const HnjJustProfile *profile)
+{
+  if (profile->greedy_min_breaks > 0 &&
+      features->n_breaks >= profile->greedy_min_breaks)
+    return HNJ_ENGINE_HS;
+  if (!features->has_tabs && features->n_lines <= profile->greedy_max_lines)
+    return HNJ_ENGINE_HS;
+  if (profile->anytime_max_usec > 0)
+    return HNJ_ENGINE_HQ_ANYTIME;
+  if (profile->parallel_min_breaks > 0 &&
+      features->n_breaks >= profile->parallel_min_breaks)
+    return HNJ_ENGINE_HQ_PARALLEL;
+  return HNJ_ENGINE_HQ;
+}
+
+int
+hnj_just_auto (const HnjBreak *breaks, int n_breaks,
+	       const HnjParams *params, const HnjJustProfile *profile,
+	       int *result, int *result_flags)
+{
+  HnjJustFeatures features;
+  HnjBreak *copy;
+  int engine;
+  int n_result;
+  int i;
+
+  if (profile == NULL)
+    profile = get_env_profile ();
+  hnj_just_features (breaks, n_breaks, params, &features);
+  engine = hnj_just_choose (&features, profile);
+#ifdef VERBOSE
+  fprintf (stderr, "auto: %d breaks, %d lines, %d words/line, %d hyphens, "
+	   "engine %d\n", features.n_breaks, features.n_lines,
+	   features.line_words, features.hyphens, engine);
+#endif
+
+  switch (engine)
+    {
+    case HNJ_ENGINE_HQ_PARALLEL:
+      return hnj_hq_just_threads (breaks, n_breaks, params, -1, result,
+				  result_flags);
+    case HNJ_ENGINE_HQ_ANYTIME:
+      return hnj_hq_just_anytime (breaks, n_breaks, params, 0,
+				  profile->anytime_max_usec, result,
+				  result_flags, NULL);
+    case HNJ_ENGINE_HS:
+      /* hnj_hs_just changes the penalties. */
+      copy = malloc ((n_breaks + 1) * sizeof (HnjBreak));
+      if (copy == NULL)
+	return -1;
+      memcpy (copy, breaks, n_breaks * sizeof (HnjBreak));
+      n_result = hnj_hs_just (copy, n_breaks, params, result);
+      free (copy);
+      if (result_flags)
+	for (i = 0; i < n_result; i++)
+	  result_flags[i] = 0;
+      return n_result;
+    default:
+      return hnj_hq_just_threads (breaks, n_breaks, params,
+				  profile->parallel_min_breaks ? 1 : 0,
+				  result, result_flags);
+    }
+}
+
+int
+hnj_just_auto_lines (const HnjBreak *breaks, int n_breaks,
+		     const HnjParams *params, const HnjJustProfile *profile,
+		     int *result, HnjLine *lines)
+{
+  int *result_flags = NULL;
+  int n_result;
+
+  if (lines)
+    {
+      result_flags = malloc ((n_breaks + 1) * sizeof (int));
+      if (result_flags == NULL)
+	return -1;
+    }
+  n_result = hnj_just_auto (breaks, n_breaks, params, profile, result,
+			    result_flags);
+  if (lines && n_result > 0)
+    hnj_hq_line_records (breaks, params, result, result_flags, n_result,
+			 lines);
+  free (result_flags);
+  return n_result;
+}
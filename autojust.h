@@ -0,0 +1,138 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_AUTOJUST_H__
+#define __HNJ_AUTOJUST_H__
+
+#include "just.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _HnjJustFeatures HnjJustFeatures;
+typedef struct _HnjJustProfile HnjJustProfile;
+
+/* The justifiers hnj_just_auto chooses from: hnj_hq_just, on one
+   thread per processor, hnj_hq_just_anytime, and hnj_hs_just. */
+#define HNJ_ENGINE_HQ 1
+#define HNJ_ENGINE_HQ_PARALLEL 2
+#define HNJ_ENGINE_HQ_ANYTIME 3
+#define HNJ_ENGINE_HS 4
+
+/* What hnj_just_auto looks at in a paragraph. n_lines is its natural
+   width over set_width, rounded up, plus one for each hard break,
+   line_words the number of words of average width (with the space
+   after them) that fit on a line, and hyphens the number of hyphen
+   breaks per 1000 breaks. has_tabs is nonzero if any break is a
+   tab. */
+struct _HnjJustFeatures {
+  int n_breaks;
+  int n_lines;
+  int line_words;
+  int hyphens;
+  int has_tabs;
+};
+
+/* Thresholds for choosing a justifier, as measured by justtune.
+
+   Paragraphs without tabs of at most greedy_max_lines lines are set
+   with hnj_hs_just, which is faster there and finds the same
+   result; 0 means never. A paragraph that fits on a line is best
+   set on it, which hnj_hs_just does too, so justtune finds this to
+   hold for paragraphs of one line at least.
+
+   Paragraphs of at least parallel_min_breaks breaks are justified on
+   one thread per processor, and smaller ones on one; -1 means always
+   on one, and 0 leaves it to hnj_hq_just, which uses threads for big
+   paragraphs on machines with several processors.
+
+   The other choices change the result, so justtune leaves them at 0:
+   they are for profiles edited by hand, where a fast worse result
+   beats a slow best one. Paragraphs of at least greedy_min_breaks
+   breaks are set with hnj_hs_just; 0 means never. If anytime_max_usec
+   isn't 0, the paragraphs left are justified with
+   hnj_hq_just_anytime, taking no more than that many microseconds
+   (on one thread) over finding the best result. */
+struct _HnjJustProfile {
+  int greedy_max_lines;
+  int parallel_min_breaks;
+  int greedy_min_breaks;
+  int anytime_max_usec;
+};
+
+/* Set profile to the built-in defaults, which justtune measured on an
+   x86-64 machine: paragraphs that fit on a line are set with
+   hnj_hs_just, and the rest with hnj_hq_just, threads and all. */
+void hnj_just_profile_init (HnjJustProfile *profile);
+
+/* Read profile from filename, a text file of "name value" lines named
+   after the fields of HnjJustProfile. Fields not in the file keep
+   their values; lines starting with # are comments. Returns 0 on
+   success, -1 if the file can't be read or has a line that isn't
+   understood. */
+int hnj_just_profile_load (HnjJustProfile *profile, const char *filename);
+
+/* Write profile to filename in the format hnj_just_profile_load
+   reads. Returns 0 on success. */
+int hnj_just_profile_save (const HnjJustProfile *profile,
+			   const char *filename);
+
+void hnj_just_features (const HnjBreak *breaks, int n_breaks,
+			const HnjParams *params, HnjJustFeatures *features);
+
+/* The justifier (HNJ_ENGINE_*) profile picks for a paragraph. */
+int hnj_just_choose (const HnjJustFeatures *features,
+		     const HnjJustProfile *profile);
+
+/* Justify with the justifier profile picks for the paragraph. With a
+   NULL profile, the one named by the LIBJUSTIFY_PROFILE environment
+   variable is used, or failing that the built-in defaults. Otherwise
+   the same as hnj_hq_just_flags and hnj_hq_just_lines, except that
+   hnj_hs_just gives no result_flags (they are all 0). */
+int hnj_just_auto (const HnjBreak *breaks, int n_breaks,
+		   const HnjParams *params, const HnjJustProfile *profile,
+		   int *result, int *result_flags);
+
+int hnj_just_auto_lines (const HnjBreak *breaks, int n_breaks,
+			 const HnjParams *params,
+			 const HnjJustProfile *profile, int *result,
+			 HnjLine *lines);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __HNJ_AUTOJUST_H__ */
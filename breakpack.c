@@ -0,0 +1,229 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Compact storage for breaks. See breakpack.h for the format. */
+
+#include <stdlib.h>
+#include "breakpack.h"
+
+#define CODE_DX_SHIFT 16
+#define CODE_FLAGS_SHIFT 12
+#define CODE_PENALTY_SHIFT 6
+#define CODE_MASK_6 0x3f
+
+#define PACKABLE_FLAGS (HNJ_JUST_FLAG_ISSPACE | HNJ_JUST_FLAG_ISHYPHEN | \
+			HNJ_JUST_FLAG_ISTAB | HNJ_JUST_FLAG_ISHARD)
+
+/* Find val in table, adding it if there's room. Returns the index, or
+   -1 if the table is full. */
+static int
+table_lookup (int *table, int *n_table, int max_table, int val)
+{
+  int i;
+
+  for (i = 0; i < *n_table; i++)
+    if (table[i] == val)
+      return i;
+  if (*n_table == max_table)
+    return -1;
+  table[*n_table] = val;
+  return (*n_table)++;
+}
+
+HnjPackedBreaks *
+hnj_packed_breaks_new (const HnjBreak *breaks, int n_breaks)
+{
+  HnjPackedBreaks *packed;
+  int n_blocks;
+  int i;
+  int x1;
+  int dx;
+  int pen_idx, gap_idx;
+
+  packed = malloc (sizeof (HnjPackedBreaks));
+  if (packed == NULL)
+    return NULL;
+  n_blocks = (n_breaks + HNJ_PACK_BLOCK - 1) / HNJ_PACK_BLOCK;
+  packed->n_breaks = n_breaks;
+  packed->codes = malloc ((n_breaks + 1) * sizeof (uint32_t));
+  packed->checkpoints = malloc ((n_blocks + 1) * 2 * sizeof (int));
+  packed->n_escapes = 0;
+  packed->escapes = NULL;
+  packed->n_penalties = 0;
+  packed->n_gaps = 0;
+  if (packed->codes == NULL || packed->checkpoints == NULL)
+    {
+      hnj_packed_breaks_free (packed);
+      return NULL;
+    }
+
+  /* First pass: codes, counting the escapes. */
+  x1 = 0;
+  for (i = 0; i < n_breaks; i++)
+    {
+      if (i % HNJ_PACK_BLOCK == 0)
+	{
+	  packed->checkpoints[i / HNJ_PACK_BLOCK * 2] = x1;
+	  packed->checkpoints[i / HNJ_PACK_BLOCK * 2 + 1] = packed->n_escapes;
+	}
+      dx = breaks[i].x0 - x1;
+      pen_idx = -1;
+      gap_idx = -1;
+      if (dx >= 0 && dx < 0xffff && !(breaks[i].flags & ~PACKABLE_FLAGS))
+	{
+	  pen_idx = table_lookup (packed->penalties, &packed->n_penalties,
+				  HNJ_PACK_N_PENALTIES, breaks[i].penalty);
+	  gap_idx = table_lookup (packed->gaps, &packed->n_gaps,
+				  HNJ_PACK_N_GAPS,
+				  breaks[i].x1 - breaks[i].x0);
+	}
+      if (pen_idx >= 0 && gap_idx >= 0)
+	packed->codes[i] = ((uint32_t) dx << CODE_DX_SHIFT) |
+	  (breaks[i].flags << CODE_FLAGS_SHIFT) |
+	  (pen_idx << CODE_PENALTY_SHIFT) | gap_idx;
+      else
+	{
+	  packed->codes[i] = HNJ_PACK_ESCAPE;
+	  packed->n_escapes++;
+	}
+      x1 = breaks[i].x1;
+    }
+
+  /* Second pass: the escapes themselves. */
+  if (packed->n_escapes)
+    {
+      int esc_idx = 0;
+
+      packed->escapes = malloc (packed->n_escapes * sizeof (HnjBreak));
+      if (packed->escapes == NULL)
+	{
+	  hnj_packed_breaks_free (packed);
+	  return NULL;
+	}
+      for (i = 0; i < n_breaks; i++)
+	if (packed->codes[i] == HNJ_PACK_ESCAPE)
+	  packed->escapes[esc_idx++] = breaks[i];
+    }
+
+  return packed;
+}
+
+void
+hnj_packed_breaks_free (HnjPackedBreaks *packed)
+{
+  if (packed == NULL)
+    return;
+  free (packed->codes);
+  free (packed->escapes);
+  free (packed->checkpoints);
+  free (packed);
+}
+
+size_t
+hnj_packed_breaks_size (const HnjPackedBreaks *packed)
+{
+  return sizeof (HnjPackedBreaks) +
+    packed->n_breaks * sizeof (uint32_t) +
+    packed->n_escapes * sizeof (HnjBreak) +
+    ((packed->n_breaks + HNJ_PACK_BLOCK - 1) / HNJ_PACK_BLOCK + 1) *
+    2 * sizeof (int);
+}
+
+void
+hnj_packed_reader_init (HnjPackedReader *reader,
+			const HnjPackedBreaks *packed, int start)
+{
+  int block;
+  HnjBreak dummy;
+
+  if (start > packed->n_breaks)
+    start = packed->n_breaks;
+  block = start / HNJ_PACK_BLOCK;
+  /* Packed breaks read from a capture file don't have checkpoints,
+     and are decoded from the start. */
+  if (packed->checkpoints == NULL)
+    block = 0;
+  reader->packed = packed;
+  reader->idx = block * HNJ_PACK_BLOCK;
+  if (block == 0)
+    {
+      reader->x1 = 0;
+      reader->esc_idx = 0;
+    }
+  else if (reader->idx < packed->n_breaks)
+    {
+      reader->x1 = packed->checkpoints[block * 2];
+      reader->esc_idx = packed->checkpoints[block * 2 + 1];
+    }
+  else
+    {
+      reader->x1 = 0;
+      reader->esc_idx = packed->n_escapes;
+    }
+  while (reader->idx < start)
+    hnj_packed_reader_read (reader, &dummy, 1);
+}
+
+int
+hnj_packed_reader_read (HnjPackedReader *reader, HnjBreak *breaks, int n)
+{
+  const HnjPackedBreaks *packed = reader->packed;
+  const uint32_t *codes = packed->codes;
+  int idx = reader->idx;
+  int x1 = reader->x1;
+  int i;
+  uint32_t code;
+
+  if (n > packed->n_breaks - idx)
+    n = packed->n_breaks - idx;
+  for (i = 0; i < n; i++)
+    {
+      code = codes[idx + i];
+      if (code == HNJ_PACK_ESCAPE)
+	breaks[i] = packed->escapes[reader->esc_idx++];
+      else
+	{
+	  breaks[i].x0 = x1 + (code >> CODE_DX_SHIFT);
+	  breaks[i].x1 = breaks[i].x0 + packed->gaps[code & CODE_MASK_6];
+	  breaks[i].penalty =
+	    packed->penalties[(code >> CODE_PENALTY_SHIFT) & CODE_MASK_6];
+	  breaks[i].flags = (code >> CODE_FLAGS_SHIFT) & PACKABLE_FLAGS;
+	}
+      x1 = breaks[i].x1;
+    }
+  reader->idx = idx + n;
+  reader->x1 = x1;
+  return n;
+}
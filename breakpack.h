@@ -0,0 +1,115 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_BREAKPACK_H__
+#define __HNJ_BREAKPACK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "just.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _HnjPackedBreaks HnjPackedBreaks;
+typedef struct _HnjPackedReader HnjPackedReader;
+
+#define HNJ_PACK_N_PENALTIES 64
+#define HNJ_PACK_N_GAPS 64
+#define HNJ_PACK_BLOCK 256
+
+/* A compact, read-only encoding of a list of breaks, for holding large
+   numbers of them in memory.
+
+   Each break takes a single 32-bit code. The top 16 bits are the
+   distance from the x1 of the previous break to the x0 of this one
+   (i.e. the width of the word or word fragment). Below that are 4 bits
+   of flags, a 6 bit index into the penalties table and a 6 bit index
+   into the gaps table, the gap being x1 - x0 (the width of the space,
+   or minus the width of the hyphen). Text usually has only a handful
+   of distinct penalties and gaps.
+
+   Breaks that don't fit (wide or out of order words, unusual flags, or
+   too many distinct penalties or gaps) have a code of
+   HNJ_PACK_ESCAPE, and are stored verbatim in escapes, in order.
+
+   checkpoints holds the x1 of the break before, and the number of
+   escapes before, every HNJ_PACK_BLOCK-th break, so that decoding can
+   start in the middle. */
+struct _HnjPackedBreaks {
+  int n_breaks;
+  uint32_t *codes;
+  int n_escapes;
+  HnjBreak *escapes;
+  int n_penalties;
+  int penalties[HNJ_PACK_N_PENALTIES];
+  int n_gaps;
+  int gaps[HNJ_PACK_N_GAPS];
+  int *checkpoints;
+};
+
+#define HNJ_PACK_ESCAPE 0xffffffffU
+
+/* Streaming decoder state. Fields are private. */
+struct _HnjPackedReader {
+  const HnjPackedBreaks *packed;
+  int idx;
+  int x1;
+  int esc_idx;
+};
+
+HnjPackedBreaks *hnj_packed_breaks_new (const HnjBreak *breaks,
+					int n_breaks);
+
+void hnj_packed_breaks_free (HnjPackedBreaks *packed);
+
+/* Number of bytes of memory held by packed. */
+size_t hnj_packed_breaks_size (const HnjPackedBreaks *packed);
+
+/* Set up reader to decode packed, starting at break start. */
+void hnj_packed_reader_init (HnjPackedReader *reader,
+			     const HnjPackedBreaks *packed, int start);
+
+/* Decode up to n breaks into breaks. Returns the number decoded, 0 at
+   the end. */
+int hnj_packed_reader_read (HnjPackedReader *reader, HnjBreak *breaks,
+			    int n);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __HNJ_BREAKPACK_H__ */
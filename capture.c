@@ -0,0 +1,271 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Capture of justification calls. See capture.h for the file format. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "capture.h"
+
+#define HEADER_SIZE 14
+#define HEADER_SIZE_V1 12
+
+static FILE *capture_file;
+
+/* Whether capture_file is set, for hnj_capture_is_open to read
+   without taking the lock. It is only written with the lock held. */
+static int capture_on;
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t capture_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t capture_env_once = PTHREAD_ONCE_INIT;
+#define CAPTURE_LOCK() pthread_mutex_lock (&capture_lock)
+#define CAPTURE_UNLOCK() pthread_mutex_unlock (&capture_lock)
+#else
+static int capture_env_checked;
+#define CAPTURE_LOCK()
+#define CAPTURE_UNLOCK()
+#endif
+
+int
+hnj_capture_write (FILE *file, int engine,
+		   const HnjBreak *breaks, int n_breaks,
+		   const HnjParams *params,
+		   const int *result, int n_result)
+{
+  HnjPackedBreaks *packed;
+  int32_t header[HEADER_SIZE];
+  int status;
+
+  packed = hnj_packed_breaks_new (breaks, n_breaks);
+  if (packed == NULL)
+    return -1;
+
+  header[0] = HNJ_CAPTURE_MAGIC;
+  header[1] = HNJ_CAPTURE_VERSION;
+  header[2] = engine;
+  header[3] = params->set_width;
+  header[4] = params->max_neg_space;
+  header[5] = params->tab_width;
+  header[6] = n_breaks;
+  header[7] = packed->n_penalties;
+  header[8] = packed->n_gaps;
+  header[9] = packed->n_escapes;
+  header[10] = result ? n_result : -1;
+  header[11] = sizeof (header) +
+    (packed->n_penalties + packed->n_gaps) * sizeof (int32_t) +
+    n_breaks * sizeof (uint32_t) +
+    packed->n_escapes * 4 * sizeof (int32_t) +
+    (result ? n_result : 0) * sizeof (int32_t);
+  header[12] = params->max_expand;
+  header[13] = params->max_shrink;
+
+  status = 0;
+  if (fwrite (header, sizeof (header), 1, file) != 1 ||
+      fwrite (packed->penalties, sizeof (int32_t), packed->n_penalties,
+	      file) != (size_t) packed->n_penalties ||
+      fwrite (packed->gaps, sizeof (int32_t), packed->n_gaps,
+	      file) != (size_t) packed->n_gaps ||
+      fwrite (packed->codes, sizeof (uint32_t), n_breaks,
+	      file) != (size_t) n_breaks ||
+      fwrite (packed->escapes, sizeof (HnjBreak), packed->n_escapes,
+	      file) != (size_t) packed->n_escapes ||
+      (result && fwrite (result, sizeof (int32_t), n_result,
+			 file) != (size_t) n_result))
+    status = -1;
+
+  hnj_packed_breaks_free (packed);
+  return status;
+}
+
+long
+hnj_capture_parse (const void *data, size_t size, HnjCapture *capture)
+{
+  const int32_t *header = data;
+  const int32_t *p;
+  const uint32_t *codes;
+  long rec_size;
+  int header_size;
+  int n_breaks, n_penalties, n_gaps, n_escapes, n_result;
+  int i, n_codes_escaped;
+
+  if (size == 0)
+    return 0;
+  if (size < HEADER_SIZE_V1 * sizeof (int32_t) ||
+      header[0] != HNJ_CAPTURE_MAGIC ||
+      header[1] < 1 || header[1] > HNJ_CAPTURE_VERSION)
+    return -1;
+  header_size = header[1] == 1 ? HEADER_SIZE_V1 : HEADER_SIZE;
+  if (size < header_size * sizeof (int32_t))
+    return -1;
+
+  n_breaks = header[6];
+  n_penalties = header[7];
+  n_gaps = header[8];
+  n_escapes = header[9];
+  n_result = header[10];
+  if (n_breaks < 0 || n_escapes < 0 || n_result < -1 ||
+      n_penalties < 0 || n_penalties > HNJ_PACK_N_PENALTIES ||
+      n_gaps < 0 || n_gaps > HNJ_PACK_N_GAPS)
+    return -1;
+  rec_size = (header_size + n_penalties + n_gaps + (long) n_breaks +
+	      4L * n_escapes + (n_result > 0 ? n_result : 0)) *
+    sizeof (int32_t);
+  if (rec_size != header[11] || (size_t) rec_size > size)
+    return -1;
+
+  /* Each code must index the tables it comes with, and there must be
+     exactly one stored break for each escape, or decoding would read
+     out of bounds. */
+  codes = (const uint32_t *) (header + header_size + n_penalties + n_gaps);
+  n_codes_escaped = 0;
+  for (i = 0; i < n_breaks; i++)
+    {
+      if (codes[i] == HNJ_PACK_ESCAPE)
+	n_codes_escaped++;
+      else if ((int) ((codes[i] >> 6) & 0x3f) >= n_penalties ||
+	       (int) (codes[i] & 0x3f) >= n_gaps)
+	return -1;
+    }
+  if (n_codes_escaped != n_escapes)
+    return -1;
+
+  capture->engine = header[2];
+  capture->params.set_width = header[3];
+  capture->params.max_neg_space = header[4];
+  capture->params.tab_width = header[5];
+  capture->params.max_expand = 0;
+  capture->params.max_shrink = 0;
+  if (header_size == HEADER_SIZE)
+    {
+      capture->params.max_expand = header[12];
+      capture->params.max_shrink = header[13];
+    }
+
+  p = header + header_size;
+  capture->packed.n_breaks = n_breaks;
+  capture->packed.n_penalties = n_penalties;
+  memcpy (capture->packed.penalties, p, n_penalties * sizeof (int32_t));
+  p += n_penalties;
+  capture->packed.n_gaps = n_gaps;
+  memcpy (capture->packed.gaps, p, n_gaps * sizeof (int32_t));
+  p += n_gaps;
+  capture->packed.codes = (uint32_t *) p;
+  p += n_breaks;
+  capture->packed.n_escapes = n_escapes;
+  capture->packed.escapes = (HnjBreak *) p;
+  p += 4 * n_escapes;
+  capture->packed.checkpoints = NULL;
+  capture->n_result = n_result;
+  capture->result = n_result >= 0 ? p : NULL;
+
+  return rec_size;
+}
+
+int
+hnj_capture_open (const char *filename)
+{
+  FILE *file;
+
+  file = fopen (filename, "ab");
+  if (file == NULL)
+    return -1;
+  CAPTURE_LOCK ();
+  if (capture_file)
+    fclose (capture_file);
+  capture_file = file;
+  __atomic_store_n (&capture_on, 1, __ATOMIC_RELEASE);
+  CAPTURE_UNLOCK ();
+  return 0;
+}
+
+void
+hnj_capture_close (void)
+{
+  CAPTURE_LOCK ();
+  if (capture_file)
+    fclose (capture_file);
+  capture_file = NULL;
+  __atomic_store_n (&capture_on, 0, __ATOMIC_RELEASE);
+  CAPTURE_UNLOCK ();
+}
+
+static void
+capture_check_env (void)
+{
+  const char *filename = getenv ("LIBJUSTIFY_CAPTURE");
+
+  if (filename && *filename)
+    hnj_capture_open (filename);
+}
+
+int
+hnj_capture_is_open (void)
+{
+#ifdef HAVE_PTHREAD
+  pthread_once (&capture_env_once, capture_check_env);
+#else
+  if (!capture_env_checked)
+    {
+      capture_env_checked = 1;
+      capture_check_env ();
+    }
+#endif
+  /* hnj_capture_record checks capture_file again under the lock, so
+     a stale answer only costs a wasted call. */
+  return __atomic_load_n (&capture_on, __ATOMIC_ACQUIRE);
+}
+
+void
+hnj_capture_record (int engine, const HnjBreak *breaks, int n_breaks,
+		    const HnjParams *params,
+		    const int *result, int n_result)
+{
+  CAPTURE_LOCK ();
+  if (capture_file)
+    {
+      hnj_capture_write (capture_file, engine, breaks, n_breaks, params,
+			 result, n_result);
+      fflush (capture_file);
+    }
+  CAPTURE_UNLOCK ();
+}
@@ -0,0 +1,121 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_CAPTURE_H__
+#define __HNJ_CAPTURE_H__
+
+#include <stdio.h>
+#include "just.h"
+#include "breakpack.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _HnjCapture HnjCapture;
+
+/* Capture of justification calls, for replaying them offline.
+
+   A capture file is a sequence of records, each holding the engine,
+   the parameters and the breaks of one call, and optionally the
+   result it produced. The breaks are stored in the packed format of
+   breakpack.h. All fields are 32-bit, in the byte order of the machine
+   that wrote the file:
+
+     magic, version, engine, set_width, max_neg_space, tab_width,
+     n_breaks, n_penalties, n_gaps, n_escapes, n_result, size,
+     max_expand, max_shrink
+     penalties[n_penalties], gaps[n_gaps], codes[n_breaks],
+     escapes[n_escapes] (x0, x1, penalty, flags each),
+     result[n_result]
+
+   size is the size of the whole record in bytes, and n_result is -1
+   if the record has no result. Version 1 records, which are still
+   read, lack max_expand and max_shrink. */
+
+#define HNJ_CAPTURE_MAGIC 0x434a4e48 /* "HNJC" */
+#define HNJ_CAPTURE_VERSION 2
+
+/* Calls to hnj_hq_just_anytime are captured as HNJ_CAPTURE_HQ, with
+   no result if they ran out of budget. */
+#define HNJ_CAPTURE_HQ 1
+#define HNJ_CAPTURE_HS 2
+
+/* A parsed record. The arrays point into the buffer the record was
+   parsed from; packed can be decoded with an HnjPackedReader starting
+   at break 0. */
+struct _HnjCapture {
+  int engine;
+  HnjParams params;
+  HnjPackedBreaks packed;
+  int n_result;
+  const int *result;
+};
+
+/* Append a record for one call to file. Returns 0 on success. */
+int hnj_capture_write (FILE *file, int engine,
+		       const HnjBreak *breaks, int n_breaks,
+		       const HnjParams *params,
+		       const int *result, int n_result);
+
+/* Parse the record at the start of data. Returns the size of the
+   record, 0 if size is 0, or -1 if the data is not a valid record,
+   including codes that index past the penalty and gap tables or a
+   count of escapes that doesn't match the codes. */
+long hnj_capture_parse (const void *data, size_t size,
+			HnjCapture *capture);
+
+/* Start capturing every call to the justifiers to filename, appending
+   to it. Capturing also starts on the first call if the
+   LIBJUSTIFY_CAPTURE environment variable names a file. Returns 0 on
+   success. */
+int hnj_capture_open (const char *filename);
+
+void hnj_capture_close (void);
+
+/* Nonzero if calls are being captured. This only reads a flag, so it
+   is cheap enough to test on every call. */
+int hnj_capture_is_open (void);
+
+/* Called by the justifiers to capture one call. */
+void hnj_capture_record (int engine, const HnjBreak *breaks, int n_breaks,
+			 const HnjParams *params,
+			 const int *result, int n_result);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __HNJ_CAPTURE_H__ */
@@ -0,0 +1,269 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* High quality justification. The algorithm lives in just.hh; this is
+   its instantiation for the C interface. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_PTHREAD
+#define HNJ_USE_PTHREAD
+#endif
+
+#include "just.hh"
+
+#include "hqjust.h"
+#include "capture.h"
+#include "trace.h"
+
+HNJ_TRACE_STAGE (hq_just_stage, "hq_just");
+
+/* Justify on up to max_threads threads, filling in lines if it isn't
+   NULL, and capture the call. */
+static int
+hq_just_lines (const HnjBreak *breaks, int n_breaks, const HnjParams *params,
+	       int max_threads, int *result, int *result_flags,
+	       HnjLine *lines)
+{
+  hnj::HqJust<hnj::DefaultCost, const HnjBreak *, int> just (breaks, n_breaks,
+							     params);
+  long long t0;
+  int n_result;
+
+  t0 = hnj_trace_begin ();
+  just.set_max_threads (max_threads);
+  just.set_lines (lines);
+  n_result = just.run (result, result_flags);
+  hnj_trace_end (&hq_just_stage, t0, "n_breaks", n_breaks);
+
+  if (n_result >= 0 && hnj_capture_is_open ())
+    hnj_capture_record (HNJ_CAPTURE_HQ, breaks, n_breaks, params,
+			result, n_result);
+
+  return n_result;
+}
+
+int
+hnj_hq_just_threads (const HnjBreak *breaks, int n_breaks,
+		     const HnjParams *params, int max_threads, int *result,
+		     int *result_flags)
+{
+  return hq_just_lines (breaks, n_breaks, params, max_threads, result,
+			result_flags, NULL);
+}
+
+int
+hnj_hq_just_flags (const HnjBreak *breaks, int n_breaks,
+		   const HnjParams *params, int *result, int *result_flags)
+{
+  return hnj_hq_just_threads (breaks, n_breaks, params, 0, result,
+			      result_flags);
+}
+
+/* The search goes back and forth over a window of the paragraph, so
+   the breaks are decoded a block at a time as it gets to them, and
+   only the last few blocks are kept. The cache isn't shared between
+   threads, so this runs on one. */
+int
+hnj_hq_just_packed (const HnjPackedBreaks *packed, const HnjParams *params,
+		    int *result, int *result_flags)
+{
+  hnj::PackedCache *cache;
+  hnj::PackedBreaks breaks;
+  HnjBreak *captured;
+  HnjPackedReader reader;
+  long long t0;
+  int n_result;
+
+  cache = (hnj::PackedCache *) malloc (sizeof (hnj::PackedCache));
+  if (cache == NULL)
+    return -1;
+  cache->init (packed);
+  breaks.cache = cache;
+
+  hnj::HqJust<hnj::DefaultCost, hnj::PackedBreaks, int> just
+    (breaks, packed->n_breaks, params);
+
+  t0 = hnj_trace_begin ();
+  just.set_max_threads (1);
+  n_result = just.run (result, result_flags);
+  hnj_trace_end (&hq_just_stage, t0, "n_breaks", packed->n_breaks);
+  free (cache);
+
+  if (n_result >= 0 && hnj_capture_is_open ())
+    {
+      captured = (HnjBreak *) malloc (packed->n_breaks * sizeof (HnjBreak) +
+				      1);
+      if (captured)
+	{
+	  hnj_packed_reader_init (&reader, packed, 0);
+	  hnj_packed_reader_read (&reader, captured, packed->n_breaks);
+	  hnj_capture_record (HNJ_CAPTURE_HQ, captured, packed->n_breaks,
+			      params, result, n_result);
+	  free (captured);
+	}
+    }
+
+  return n_result;
+}
+
+void
+hnj_hq_line_records (const HnjBreak *breaks, const HnjParams *params,
+		     const int *result, const int *result_flags,
+		     int n_result, HnjLine *lines)
+{
+  hnj::line_records<hnj::DefaultCost, long long> (breaks, params, result,
+						  result_flags, n_result,
+						  lines);
+}
+
+/* The lines are laid out as the best path is read out. */
+int
+hnj_hq_just_lines (const HnjBreak *breaks, int n_breaks,
+		   const HnjParams *params, int *result, HnjLine *lines)
+{
+  return hq_just_lines (breaks, n_breaks, params, 0, result, NULL, lines);
+}
+
+int
+hnj_hq_just_anytime (const HnjBreak *breaks, int n_breaks,
+		     const HnjParams *params, long max_work, long max_usec,
+		     int *result, int *result_flags, int *optimal)
+{
+  hnj::Budget budget;
+  struct timespec ts;
+  long long t0;
+  int n_result;
+
+  budget.work = max_work > 0 ? max_work : -1;
+  budget.deadline = 0;
+  budget.steps = 0;
+  budget.exhausted = false;
+  if (max_usec > 0)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &ts);
+      budget.deadline = ts.tv_sec * 1000000000LL + ts.tv_nsec +
+	max_usec * 1000LL;
+    }
+
+  t0 = hnj_trace_begin ();
+  n_result = hnj::hq_just<hnj::DefaultCost, int> (breaks, n_breaks, params,
+						  result, result_flags,
+						  &budget);
+  hnj_trace_end (&hq_just_stage, t0, "n_breaks", n_breaks);
+#ifdef VERBOSE
+  fprintf (stderr, "anytime: %ld steps, %s\n", budget.steps,
+	   budget.exhausted ? "out of budget" : "optimal");
+#endif
+  if (optimal)
+    *optimal = !budget.exhausted;
+
+  /* Replays run without a budget, so a result cut short is left out
+     rather than reported as a mismatch. */
+  if (n_result >= 0 && hnj_capture_is_open ())
+    hnj_capture_record (HNJ_CAPTURE_HQ, breaks, n_breaks, params,
+			budget.exhausted ? NULL : result, n_result);
+  return n_result;
+}
+
+long
+hnj_hq_just_steps (const HnjBreak *breaks, int n_breaks,
+		   const HnjParams *params)
+{
+  hnj::Budget budget;
+  int *result;
+  int n_result;
+
+  result = (int *) malloc ((n_breaks + 1) * sizeof (int));
+  if (result == NULL)
+    return -1;
+  budget.work = -1;
+  budget.deadline = 0;
+  budget.steps = 0;
+  budget.exhausted = false;
+  n_result = hnj::hq_just<hnj::DefaultCost, int> (breaks, n_breaks, params,
+						  result, NULL, &budget);
+  free (result);
+  return n_result < 0 ? -1 : budget.steps;
+}
+
+int
+hnj_prune_breaks (const HnjBreak *breaks, int n_breaks,
+		  const HnjParams *params, HnjBreak *pruned, int *map)
+{
+  return hnj::prune_breaks<hnj::DefaultCost> (breaks, n_breaks, params,
+					       pruned, map);
+}
+
+int
+hnj_hq_just_pruned (const HnjBreak *breaks, int n_breaks,
+		    const HnjParams *params, int *result, int *result_flags)
+{
+  HnjBreak *pruned;
+  int *map;
+  int n_pruned;
+  int n_result;
+  int i;
+
+  pruned = (HnjBreak *) malloc ((n_breaks + 1) * sizeof (HnjBreak));
+  map = (int *) malloc ((n_breaks + 1) * sizeof (int));
+  if (pruned == NULL || map == NULL)
+    {
+      free (pruned);
+      free (map);
+      return -1;
+    }
+  n_pruned = hnj_prune_breaks (breaks, n_breaks, params, pruned, map);
+#ifdef VERBOSE
+  fprintf (stderr, "pruned %d of %d breaks\n", n_breaks - n_pruned,
+	   n_breaks);
+#endif
+  n_result = hnj_hq_just_flags (pruned, n_pruned, params, result,
+				result_flags);
+  for (i = 0; i < n_result; i++)
+    result[i] = map[result[i]];
+  free (pruned);
+  free (map);
+  return n_result;
+}
+
+int
+hnj_hq_just (const HnjBreak *breaks, int n_breaks,
+	     const HnjParams *params, int *result)
+{
+  return hnj_hq_just_flags (breaks, n_breaks, params, result, NULL);
+}
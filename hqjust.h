@@ -37,15 +37,95 @@
 #define __HNJ_HQJUST_H__
 
 #include "just.h"
+#include "breakpack.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
 
-/* Return value is number of breaks in result. */
+/* Return value is number of breaks in result, or -1 if out of
+   memory. result must have room for n_breaks entries. */
 int hnj_hq_just (const HnjBreak *breaks, int n_breaks,
 		 const HnjParams *params, int *result);
 
+/* Same as hnj_hq_just, but also fills result_flags (if non-NULL) with
+   HNJ_JUST_LINE_* flags for each line of the result. */
+int hnj_hq_just_flags (const HnjBreak *breaks, int n_breaks,
+		       const HnjParams *params, int *result,
+		       int *result_flags);
+
+/* Same as hnj_hq_just_flags, but uses up to max_threads threads,
+   whatever the number of processors, or as many as there are
+   processors if max_threads is negative. 0 leaves it to the default,
+   which is to use several threads for big paragraphs only. Threads
+   are only ever used where the library was built with them, for
+   paragraphs of more than a thousand or so breaks, and as far as the
+   paragraph can be cut into pieces whose best paths are
+   independent. */
+int hnj_hq_just_threads (const HnjBreak *breaks, int n_breaks,
+			 const HnjParams *params, int max_threads,
+			 int *result, int *result_flags);
+
+/* Same as hnj_hq_just_flags, for packed breaks (see breakpack.h).
+   The breaks are decoded a block at a time as they are needed, on a
+   single thread, so the paragraph is never held decoded whole.
+   Returns -1 if out of memory. */
+int hnj_hq_just_packed (const HnjPackedBreaks *packed,
+			const HnjParams *params, int *result,
+			int *result_flags);
+
+/* Fill in lines with the layout of the n_result lines of result, as
+   returned by any of the justifiers. result_flags may be NULL. */
+void hnj_hq_line_records (const HnjBreak *breaks, const HnjParams *params,
+			  const int *result, const int *result_flags,
+			  int n_result, HnjLine *lines);
+
+/* Same as hnj_hq_just, but also fills lines (if non-NULL) with the
+   layout of each line of the result. lines must have room for
+   n_breaks entries. */
+int hnj_hq_just_lines (const HnjBreak *breaks, int n_breaks,
+		       const HnjParams *params, int *result,
+		       HnjLine *lines);
+
+/* Same as hnj_hq_just_flags, but with a limit on the time spent
+   searching for the best result: max_work steps of the search, and
+   max_usec microseconds; either may be 0 for no limit. The result is
+   seeded with a greedy breaking, which the search improves on for as
+   long as the limit allows, so it is always complete, and *optimal
+   (if optimal isn't NULL) tells whether it is also the best. Finding
+   the independent parts of the paragraph and the greedy breaking
+   take time linear in n_breaks on top of the limit. Returns -1 if
+   out of memory. */
+int hnj_hq_just_anytime (const HnjBreak *breaks, int n_breaks,
+			 const HnjParams *params, long max_work,
+			 long max_usec, int *result, int *result_flags,
+			 int *optimal);
+
+/* Copy to pruned the breaks that may be on the least cost path of
+   hnj_hq_just, dropping the rest, and set map[i] to the index in
+   breaks of pruned[i]. Justifying pruned instead of breaks gives a
+   result of the same cost, once its indices are mapped back. Breaks
+   are dropped if their penalty alone costs more than a greedy
+   breaking, or if they duplicate a cheaper break at the same place.
+   Takes time linear in n_breaks for a given set width. pruned and
+   map must have room for n_breaks entries. Returns the number of
+   breaks kept. */
+int hnj_prune_breaks (const HnjBreak *breaks, int n_breaks,
+		      const HnjParams *params, HnjBreak *pruned, int *map);
+
+/* Same as hnj_hq_just_flags, but runs hnj_prune_breaks first. Returns
+   -1 if out of memory. */
+int hnj_hq_just_pruned (const HnjBreak *breaks, int n_breaks,
+			const HnjParams *params, int *result,
+			int *result_flags);
+
+/* The number of steps hnj_hq_just takes to justify breaks: entries
+   taken off the queue of its search, which visit a break or try a
+   line. For measuring how much work a paragraph is, and what pruning
+   saves. Returns -1 if out of memory. */
+long hnj_hq_just_steps (const HnjBreak *breaks, int n_breaks,
+			const HnjParams *params);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
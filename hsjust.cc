@@ -0,0 +1,146 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* High speed justification. The algorithm lives in just.hh; this is
+   its instantiation for the C interface. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "just.hh"
+
+#include "hsjust.h"
+#include "capture.h"
+#include "trace.h"
+
+HNJ_TRACE_STAGE (hs_just_stage, "hs_just");
+
+int
+hnj_hs_just (HnjBreak *breaks, int n_breaks,
+	     const HnjParams *params, int *result)
+{
+  HnjBreak *captured = NULL;
+  long long t0;
+  int n_result;
+
+  /* The penalties get adjusted by the justifier, so capture the
+     breaks as they were passed in. */
+  if (hnj_capture_is_open ())
+    {
+      captured = (HnjBreak *) malloc (n_breaks * sizeof (HnjBreak) + 1);
+      if (captured)
+	memcpy (captured, breaks, n_breaks * sizeof (HnjBreak));
+    }
+
+  t0 = hnj_trace_begin ();
+  n_result = hnj::hs_just<hnj::GreedyCost, long long> (breaks, n_breaks,
+						       params, result);
+  hnj_trace_end (&hs_just_stage, t0, "n_breaks", n_breaks);
+
+  if (captured)
+    {
+      hnj_capture_record (HNJ_CAPTURE_HS, captured, n_breaks, params,
+			  result, n_result);
+      free (captured);
+    }
+
+  return n_result;
+}
+
+int
+hnj_hs_just_lines (HnjBreak *breaks, int n_breaks,
+		   const HnjParams *params, int *result, HnjLine *lines)
+{
+  int n_result;
+
+  n_result = hnj_hs_just (breaks, n_breaks, params, result);
+  if (lines && n_result > 0)
+    hnj::line_records<hnj::DefaultCost, long long> (breaks, params, result,
+						    NULL, n_result, lines);
+  return n_result;
+}
+
+/* hs_just only adjusts penalties where the x0 of the breaks go
+   backwards, which the packed format escapes anyway and text hardly
+   ever has, so the breaks are checked for that first, and otherwise
+   decoded a block at a time as they are needed. */
+int
+hnj_hs_just_packed (const HnjPackedBreaks *packed, const HnjParams *params,
+		    int *result)
+{
+  hnj::PackedCache *cache;
+  hnj::PackedBreaks breaks;
+  HnjBreak *unpacked;
+  HnjBreak brk;
+  HnjPackedReader reader;
+  long long t0;
+  int x0;
+  int n_result;
+  int i;
+
+  hnj_packed_reader_init (&reader, packed, 0);
+  x0 = INT_MIN;
+  for (i = 0; i < packed->n_breaks; i++)
+    {
+      hnj_packed_reader_read (&reader, &brk, 1);
+      if (brk.x0 < x0)
+	break;
+      x0 = brk.x0;
+    }
+  if (i < packed->n_breaks || hnj_capture_is_open ())
+    {
+      unpacked = (HnjBreak *) malloc ((packed->n_breaks + 1) *
+				      sizeof (HnjBreak));
+      if (unpacked == NULL)
+	return -1;
+      hnj_packed_reader_init (&reader, packed, 0);
+      hnj_packed_reader_read (&reader, unpacked, packed->n_breaks);
+      n_result = hnj_hs_just (unpacked, packed->n_breaks, params, result);
+      free (unpacked);
+      return n_result;
+    }
+
+  cache = (hnj::PackedCache *) malloc (sizeof (hnj::PackedCache));
+  if (cache == NULL)
+    return -1;
+  cache->init (packed);
+  breaks.cache = cache;
+
+  t0 = hnj_trace_begin ();
+  n_result = hnj::hs_just_unadjusted<hnj::GreedyCost, long long>
+    (breaks, packed->n_breaks, params, result);
+  hnj_trace_end (&hs_just_stage, t0, "n_breaks", packed->n_breaks);
+  free (cache);
+  return n_result;
+}
@@ -37,6 +37,7 @@
 #define __HNJ_HSJUST_H__
 
 #include "just.h"
+#include "breakpack.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,6 +47,20 @@ extern "C" {
 int hnj_hs_just (HnjBreak *breaks, int n_breaks,
 		 const HnjParams *params, int *result);
 
+/* Same as hnj_hs_just, but also fills lines (if non-NULL) with the
+   layout of each line of the result, costed as hnj_hq_just would.
+   lines must have room for n_breaks entries. */
+int hnj_hs_just_lines (HnjBreak *breaks, int n_breaks,
+		       const HnjParams *params, int *result,
+		       HnjLine *lines);
+
+/* Same as hnj_hs_just, for packed breaks (see breakpack.h), which
+   are left as they are. The breaks are decoded a block at a time as
+   they are needed, unless their x0 go backwards somewhere, which
+   takes a decoded copy. Returns -1 if out of memory. */
+int hnj_hs_just_packed (const HnjPackedBreaks *packed,
+			const HnjParams *params, int *result);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,184 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+
+/* Check of hnj_hyph_trie against libhyphen.
+
+   Usage: hyphcheck [-n words] [-s seed] [-v] patterns
+
+   Compiles patterns (in the format libhyphen loads) with
+   hnj_hyph_trie_compile, loads them with hnj_hyphen_load too, and
+   hyphenates a list of English words and random words over the
+   letters of the patterns with both. The breaks found must be the
+   same. The patterns must be ASCII and have a single level. Exits
+   nonzero on any mismatch. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <hyphen.h>
+#include "hyphtrie.h"
+
+#define TRIE_FN "hyphcheck.trie"
+#define MAX_WORD 24
+
+static const char *const fixed_words[] = {
+  "hyphenation", "hyphen", "henatop", "concatenation", "tapestry",
+  "reiterate", "unanimous", "unable", "probably", "address",
+  "alien", "arable", "beta", "nation", "ratio", "pepper", "tattle",
+  "running", "singing", "essence", "a", "ab", "abc", "tap", "tape"
+};
+
+#define N_FIXED_WORDS (sizeof (fixed_words) / sizeof (fixed_words[0]))
+
+static const char letters[] = "abdeghilnoprstuy";
+
+static void
+usage (void)
+{
+  fprintf (stderr, "usage: hyphcheck [-n words] [-s seed] [-v] patterns\n");
+}
+
+/* Hyphenate word with trie and dict, returning 0 if they agree. */
+static int
+check_word (const HnjHyphTrie *trie, HyphenDict *dict, const char *word,
+	    int verbose)
+{
+  char trie_hyphens[MAX_WORD + 5];
+  char dict_hyphens[MAX_WORD + 5];
+  char **rep = NULL;
+  int *pos = NULL;
+  int *cut = NULL;
+  int len = strlen (word);
+  int status = 0;
+  int j;
+
+  hnj_hyph_trie_hyphenate (trie, word, len, trie_hyphens);
+  hnj_hyphen_hyphenate2 (dict, word, len, dict_hyphens, NULL, &rep, &pos,
+			 &cut);
+  if (rep)
+    {
+      for (j = 0; j < len; j++)
+	free (rep[j]);
+      free (rep);
+      free (pos);
+      free (cut);
+    }
+  for (j = 0; j < len; j++)
+    if ((trie_hyphens[j] & 1) != (dict_hyphens[j] & 1))
+      status = -1;
+  if (status || verbose)
+    {
+      fprintf (stderr, "%s: trie ", word);
+      for (j = 0; j < len; j++)
+	fprintf (stderr, "%c%s", word[j], trie_hyphens[j] & 1 ? "-" : "");
+      fprintf (stderr, ", libhyphen ");
+      for (j = 0; j < len; j++)
+	fprintf (stderr, "%c%s", word[j], dict_hyphens[j] & 1 ? "-" : "");
+      fprintf (stderr, "\n");
+    }
+  return status;
+}
+
+int
+main (int argc, char **argv)
+{
+  int n_words = 10000;
+  unsigned int seed = 1;
+  int verbose = 0;
+  const char *patterns_fn = NULL;
+  HnjHyphTrie *trie;
+  HyphenDict *dict;
+  char word[MAX_WORD + 1];
+  int n_failed = 0;
+  int len;
+  int i, j;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (!strcmp (argv[i], "-n") && i + 1 < argc)
+	n_words = atoi (argv[++i]);
+      else if (!strcmp (argv[i], "-s") && i + 1 < argc)
+	seed = strtoul (argv[++i], NULL, 0);
+      else if (!strcmp (argv[i], "-v"))
+	verbose = 1;
+      else if (argv[i][0] != '-' && patterns_fn == NULL)
+	patterns_fn = argv[i];
+      else
+	{
+	  usage ();
+	  return 1;
+	}
+    }
+  if (patterns_fn == NULL)
+    {
+      usage ();
+      return 1;
+    }
+
+  if (hnj_hyph_trie_compile (patterns_fn, TRIE_FN))
+    {
+      fprintf (stderr, "hyphcheck: can't compile %s\n", patterns_fn);
+      return 1;
+    }
+  trie = hnj_hyph_trie_open (TRIE_FN);
+  dict = hnj_hyphen_load (patterns_fn);
+  if (trie == NULL || dict == NULL)
+    {
+      fprintf (stderr, "hyphcheck: can't load %s\n", patterns_fn);
+      return 1;
+    }
+
+  for (i = 0; i < (int) N_FIXED_WORDS; i++)
+    if (check_word (trie, dict, fixed_words[i], verbose))
+      n_failed++;
+  srand (seed);
+  for (i = 0; i < n_words; i++)
+    {
+      len = 1 + rand () % MAX_WORD;
+      for (j = 0; j < len; j++)
+	word[j] = letters[rand () % (sizeof (letters) - 1)];
+      word[len] = '\0';
+      if (check_word (trie, dict, word, verbose))
+	n_failed++;
+    }
+
+  printf ("%d words, %d mismatches\n", (int) N_FIXED_WORDS + n_words,
+	  n_failed);
+  hnj_hyph_trie_close (trie);
+  hnj_hyphen_free (dict);
+  remove (TRIE_FN);
+  return n_failed != 0;
+}
@@ -0,0 +1,94 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Compile hyphenation patterns for hnj_hyph_trie_open.
+
+   Usage: hyphcomp patterns trie [word...]
+
+   Reads patterns in the format libhyphen loads (such as
+   hyphen.mashed) and writes the compiled trie. Any words given are
+   then hyphenated with the trie as written, as a check. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hyphtrie.h"
+
+int
+main (int argc, char **argv)
+{
+  HnjHyphTrie *trie;
+  char *hyphens;
+  int len;
+  int i, j;
+
+  if (argc < 3)
+    {
+      fprintf (stderr, "usage: hyphcomp patterns trie [word...]\n");
+      return 1;
+    }
+  if (hnj_hyph_trie_compile (argv[1], argv[2]))
+    {
+      fprintf (stderr, "hyphcomp: can't compile %s to %s\n", argv[1], argv[2]);
+      return 1;
+    }
+  if (argc == 3)
+    return 0;
+
+  trie = hnj_hyph_trie_open (argv[2]);
+  if (trie == NULL)
+    {
+      fprintf (stderr, "hyphcomp: can't open %s\n", argv[2]);
+      return 1;
+    }
+  for (i = 3; i < argc; i++)
+    {
+      len = strlen (argv[i]);
+      hyphens = malloc (len + 1);
+      if (hyphens == NULL)
+	return 1;
+      hnj_hyph_trie_hyphenate (trie, argv[i], len, hyphens);
+      for (j = 0; j < len; j++)
+	{
+	  putchar (argv[i][j]);
+	  if (hyphens[j] & 1)
+	    putchar ('-');
+	}
+      putchar ('\n');
+      free (hyphens);
+    }
+  hnj_hyph_trie_close (trie);
+  return 0;
+}
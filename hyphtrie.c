@@ -0,0 +1,556 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Compiled hyphenation patterns. See hyphtrie.h for the format. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hyphtrie.h"
+
+#define HEADER_SIZE 9
+#define NODE_SIZE 3
+
+/* Longest pattern, in bytes. The number of values has to fit in a
+   byte. */
+#define MAX_PATTERN 254
+
+/* Applied when the patterns don't set them, as by libhyphen. */
+#define DEFAULT_LHMIN 2
+#define DEFAULT_RHMIN 2
+
+struct _HnjHyphTrie {
+  void *map;
+  size_t map_size;
+  const uint32_t *header;
+  const uint32_t *nodes;
+  const uint32_t *edges;
+  const unsigned char *values;
+  int n_nodes;
+};
+
+/* A node of the trie while it's being built. Children are kept in a
+   list sorted by byte. */
+typedef struct {
+  int child;
+  int sibling;
+  int values;
+  int n_values;
+  unsigned char ch;
+} BuildNode;
+
+typedef struct {
+  BuildNode *nodes;
+  int n_nodes;
+  int nodes_size;
+  unsigned char *values;
+  int n_values;
+  int values_size;
+} Builder;
+
+static int
+builder_new_node (Builder *b, unsigned char ch)
+{
+  BuildNode *n;
+
+  if (b->n_nodes == b->nodes_size)
+    {
+      BuildNode *new_nodes;
+
+      new_nodes = realloc (b->nodes, b->nodes_size * 2 * sizeof (BuildNode));
+      if (new_nodes == NULL)
+	return -1;
+      b->nodes = new_nodes;
+      b->nodes_size *= 2;
+    }
+  n = &b->nodes[b->n_nodes];
+  n->child = -1;
+  n->sibling = -1;
+  n->values = 0;
+  n->n_values = 0;
+  n->ch = ch;
+  return b->n_nodes++;
+}
+
+/* The child of node i by ch, added if need be. Returns -1 if out of
+   memory. */
+static int
+builder_child (Builder *b, int i, unsigned char ch)
+{
+  int prev = -1;
+  int j;
+
+  for (j = b->nodes[i].child; j >= 0 && b->nodes[j].ch < ch;
+       j = b->nodes[j].sibling)
+    prev = j;
+  if (j >= 0 && b->nodes[j].ch == ch)
+    return j;
+
+  /* Nodes are linked by index, since adding one may move them. */
+  j = builder_new_node (b, ch);
+  if (j < 0)
+    return -1;
+  if (prev < 0)
+    {
+      b->nodes[j].sibling = b->nodes[i].child;
+      b->nodes[i].child = j;
+    }
+  else
+    {
+      b->nodes[j].sibling = b->nodes[prev].sibling;
+      b->nodes[prev].sibling = j;
+    }
+  return j;
+}
+
+/* Set the values of node i to digits, or to their maximum with the
+   ones it already has if the pattern comes twice. */
+static int
+builder_set_values (Builder *b, int i, const unsigned char *digits,
+		    int n_digits)
+{
+  BuildNode *n = &b->nodes[i];
+  int n_values;
+  int k;
+
+  n_values = n_digits > n->n_values ? n_digits : n->n_values;
+  while (b->n_values + n_values > b->values_size)
+    {
+      unsigned char *new_values;
+
+      new_values = realloc (b->values, b->values_size * 2);
+      if (new_values == NULL)
+	return -1;
+      b->values = new_values;
+      b->values_size *= 2;
+    }
+  for (k = 0; k < n_values; k++)
+    {
+      unsigned char v = k < n_digits ? digits[k] : 0;
+
+      if (k < n->n_values && b->values[n->values + k] > v)
+	v = b->values[n->values + k];
+      b->values[b->n_values + k] = v;
+    }
+  n->values = b->n_values;
+  n->n_values = n_values;
+  b->n_values += n_values;
+  return 0;
+}
+
+/* Add one pattern, such as "1na" or ".ab3l". Returns -1 if out of
+   memory or if it has more than MAX_PATTERN letters. */
+static int
+builder_add (Builder *b, const char *pattern, int len)
+{
+  unsigned char digits[MAX_PATTERN + 1];
+  int n_letters;
+  int n_digits;
+  int i;
+  int node;
+
+  memset (digits, 0, sizeof (digits));
+  n_letters = 0;
+  node = 0;
+  for (i = 0; i < len; i++)
+    {
+      if (pattern[i] >= '0' && pattern[i] <= '9')
+	digits[n_letters] = pattern[i] - '0';
+      else if (n_letters == MAX_PATTERN)
+	return -1;
+      else
+	{
+	  node = builder_child (b, node, pattern[i]);
+	  if (node < 0)
+	    return -1;
+	  n_letters++;
+	}
+    }
+  if (n_letters == 0)
+    return 0;
+  n_digits = n_letters + 1;
+  while (n_digits > 0 && digits[n_digits - 1] == 0)
+    n_digits--;
+  return builder_set_values (b, node, digits, n_digits);
+}
+
+/* Write out the trie, with the nodes in breadth first order so that
+   the children of each are consecutive. */
+static int
+builder_write (Builder *b, FILE *file, int flags, int lhmin, int rhmin)
+{
+  uint32_t header[HEADER_SIZE];
+  uint32_t *nodes;
+  uint32_t *edges;
+  int *order;
+  int n_order;
+  int n_edges;
+  int n_values;
+  int size;
+  int i, j;
+  int status = -1;
+  static const unsigned char pad[4];
+
+  nodes = malloc (b->n_nodes * NODE_SIZE * sizeof (uint32_t));
+  edges = malloc (b->n_nodes * sizeof (uint32_t));
+  order = malloc (b->n_nodes * sizeof (int));
+  if (nodes == NULL || edges == NULL || order == NULL)
+    goto done;
+
+  order[0] = 0;
+  n_order = 1;
+  n_edges = 0;
+  n_values = 0;
+  for (i = 0; i < n_order; i++)
+    {
+      const BuildNode *n = &b->nodes[order[i]];
+
+      nodes[i * NODE_SIZE] = n_edges;
+      for (j = n->child; j >= 0; j = b->nodes[j].sibling)
+	{
+	  edges[n_edges++] = ((uint32_t) n_order << 8) | b->nodes[j].ch;
+	  order[n_order++] = j;
+	}
+      nodes[i * NODE_SIZE + 1] = n_edges - nodes[i * NODE_SIZE];
+      nodes[i * NODE_SIZE + 2] = ((uint32_t) n_values << 8) | n->n_values;
+      n_values += n->n_values;
+    }
+
+  size = (HEADER_SIZE + NODE_SIZE * b->n_nodes + n_edges) * sizeof (uint32_t) +
+    (n_values + 3) / 4 * 4;
+  header[0] = HNJ_HYPH_TRIE_MAGIC;
+  header[1] = HNJ_HYPH_TRIE_VERSION;
+  header[2] = flags;
+  header[3] = lhmin;
+  header[4] = rhmin;
+  header[5] = b->n_nodes;
+  header[6] = n_edges;
+  header[7] = n_values;
+  header[8] = size;
+  if (fwrite (header, sizeof (uint32_t), HEADER_SIZE, file) != HEADER_SIZE ||
+      fwrite (nodes, sizeof (uint32_t), NODE_SIZE * b->n_nodes, file) !=
+      (size_t) (NODE_SIZE * b->n_nodes) ||
+      fwrite (edges, sizeof (uint32_t), n_edges, file) != (size_t) n_edges)
+    goto done;
+  for (i = 0; i < n_order; i++)
+    {
+      const BuildNode *n = &b->nodes[order[i]];
+
+      if (fwrite (b->values + n->values, 1, n->n_values, file) !=
+	  (size_t) n->n_values)
+	goto done;
+    }
+  if (fwrite (pad, 1, (4 - n_values % 4) % 4, file) !=
+      (size_t) (4 - n_values % 4) % 4)
+    goto done;
+  status = 0;
+
+ done:
+  free (nodes);
+  free (edges);
+  free (order);
+  return status;
+}
+
+int
+hnj_hyph_trie_compile (const char *patterns_fn, const char *trie_fn)
+{
+  FILE *in;
+  FILE *out;
+  Builder b;
+  char buf[MAX_PATTERN + 2];
+  int flags = 0;
+  int lhmin = DEFAULT_LHMIN;
+  int rhmin = DEFAULT_RHMIN;
+  int status = -1;
+  int len;
+  int val;
+
+  in = fopen (patterns_fn, "r");
+  if (in == NULL)
+    return -1;
+  b.nodes_size = 1024;
+  b.nodes = malloc (b.nodes_size * sizeof (BuildNode));
+  b.n_nodes = 0;
+  b.values_size = 4096;
+  b.values = malloc (b.values_size);
+  b.n_values = 0;
+  if (b.nodes == NULL || b.values == NULL)
+    goto done;
+  builder_new_node (&b, 0);
+
+  /* The first line names the character set. */
+  if (fgets (buf, sizeof (buf), in) && strstr (buf, "UTF-8"))
+    flags |= HNJ_HYPH_TRIE_UTF8;
+
+  while (fgets (buf, sizeof (buf), in))
+    {
+      /* A line that doesn't fit in buf would be read as several
+	 patterns. */
+      if (strchr (buf, '\n') == NULL && !feof (in))
+	goto done;
+      if (buf[0] == '%')
+	continue;
+      if (sscanf (buf, "LEFTHYPHENMIN %d", &val) == 1)
+	lhmin = val;
+      else if (sscanf (buf, "RIGHTHYPHENMIN %d", &val) == 1)
+	rhmin = val;
+      else if (!strncmp (buf, "NEXTLEVEL", 9))
+	break;
+      else if (!strncmp (buf, "COMPOUND", 8) || !strncmp (buf, "NOHYPHEN", 8))
+	continue;
+      else
+	{
+	  for (len = 0; (unsigned char) buf[len] > ' ' && buf[len] != '/'; len++)
+	    ;
+	  if (builder_add (&b, buf, len))
+	    goto done;
+	}
+    }
+
+  out = fopen (trie_fn, "wb");
+  if (out == NULL)
+    goto done;
+  status = builder_write (&b, out, flags, lhmin, rhmin);
+  if (fclose (out))
+    status = -1;
+
+ done:
+  fclose (in);
+  free (b.nodes);
+  free (b.values);
+  return status;
+}
+
+/* Check that the trie in data is whole and consistent, so that
+   hyphenating with it can't go astray. */
+static int
+trie_init (HnjHyphTrie *trie, const void *data, size_t size)
+{
+  const uint32_t *header = data;
+  uint32_t n_nodes, n_edges, n_values;
+  uint32_t i;
+  uint32_t first, n, values;
+
+  if (size < HEADER_SIZE * sizeof (uint32_t) ||
+      header[0] != HNJ_HYPH_TRIE_MAGIC || header[1] != HNJ_HYPH_TRIE_VERSION ||
+      header[8] != size)
+    return -1;
+  n_nodes = header[5];
+  n_edges = header[6];
+  n_values = header[7];
+  if (n_nodes == 0 || n_nodes >= 1 << 24 || n_edges != n_nodes - 1 ||
+      n_values >= 1 << 24 ||
+      (HEADER_SIZE + NODE_SIZE * (size_t) n_nodes + n_edges) *
+      sizeof (uint32_t) + (n_values + 3) / 4 * 4 != size)
+    return -1;
+
+  trie->header = header;
+  trie->nodes = header + HEADER_SIZE;
+  trie->edges = trie->nodes + NODE_SIZE * n_nodes;
+  trie->values = (const unsigned char *) (trie->edges + n_edges);
+  trie->n_nodes = n_nodes;
+  for (i = 0; i < n_nodes; i++)
+    {
+      first = trie->nodes[i * NODE_SIZE];
+      n = trie->nodes[i * NODE_SIZE + 1];
+      values = trie->nodes[i * NODE_SIZE + 2];
+      if (first > n_edges || n > n_edges - first ||
+	  (values >> 8) + (values & 0xff) > n_values)
+	return -1;
+    }
+  for (i = 0; i < n_edges; i++)
+    if ((trie->edges[i] >> 8) >= n_nodes)
+      return -1;
+  return 0;
+}
+
+HnjHyphTrie *
+hnj_hyph_trie_open (const char *filename)
+{
+  HnjHyphTrie *trie;
+  struct stat st;
+  void *map;
+  int fd;
+
+  fd = open (filename, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  if (fstat (fd, &st) < 0 || st.st_size == 0)
+    {
+      close (fd);
+      return NULL;
+    }
+  map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  trie = malloc (sizeof (HnjHyphTrie));
+  if (trie == NULL || trie_init (trie, map, st.st_size))
+    {
+      free (trie);
+      munmap (map, st.st_size);
+      return NULL;
+    }
+  trie->map = map;
+  trie->map_size = st.st_size;
+  return trie;
+}
+
+HnjHyphTrie *
+hnj_hyph_trie_new_from_data (const void *data, size_t size)
+{
+  HnjHyphTrie *trie;
+
+  trie = malloc (sizeof (HnjHyphTrie));
+  if (trie == NULL || trie_init (trie, data, size))
+    {
+      free (trie);
+      return NULL;
+    }
+  trie->map = NULL;
+  trie->map_size = 0;
+  return trie;
+}
+
+void
+hnj_hyph_trie_close (HnjHyphTrie *trie)
+{
+  if (trie == NULL)
+    return;
+  if (trie->map)
+    munmap (trie->map, trie->map_size);
+  free (trie);
+}
+
+/* The child of node by c, or -1. */
+static int
+trie_child (const HnjHyphTrie *trie, int node, unsigned char c)
+{
+  const uint32_t *edges = trie->edges + trie->nodes[node * NODE_SIZE];
+  int lo = 0;
+  int hi = trie->nodes[node * NODE_SIZE + 1];
+  int mid;
+
+  while (lo < hi)
+    {
+      mid = (lo + hi) >> 1;
+      if ((edges[mid] & 0xff) < c)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  if (lo < (int) trie->nodes[node * NODE_SIZE + 1] && (edges[lo] & 0xff) == c)
+    return edges[lo] >> 8;
+  return -1;
+}
+
+/* Byte k of the word with a '.' on either side, as the patterns see
+   it. Digits match as '.', as in libhyphen. */
+static unsigned char
+word_char (const char *word, int word_size, int k)
+{
+  unsigned char c;
+
+  if (k == 0 || k == word_size + 1)
+    return '.';
+  c = word[k - 1];
+  if (c >= '0' && c <= '9')
+    return '.';
+  return c;
+}
+
+int
+hnj_hyph_trie_hyphenate (const HnjHyphTrie *trie, const char *word,
+			 int word_size, char *hyphens)
+{
+  int utf8 = trie->header[2] & HNJ_HYPH_TRIE_UTF8;
+  int lhmin = trie->header[3];
+  int rhmin = trie->header[4];
+  uint32_t values;
+  const unsigned char *v;
+  int n_chars, n_before;
+  int node;
+  int i, k, m;
+  int pos;
+
+  memset (hyphens, '0', word_size);
+  hyphens[word_size] = 0;
+
+  /* The value of a match of a pattern starting at byte i of the
+     dotted word, before its letter m, goes to the break after byte
+     i + m - 2 of the word. */
+  for (i = 0; i < word_size + 2; i++)
+    {
+      node = 0;
+      for (k = i; k < word_size + 2; k++)
+	{
+	  node = trie_child (trie, node, word_char (word, word_size, k));
+	  if (node < 0)
+	    break;
+	  values = trie->nodes[node * NODE_SIZE + 2];
+	  v = trie->values + (values >> 8);
+	  for (m = 0; m < (int) (values & 0xff); m++)
+	    {
+	      pos = i + m - 2;
+	      if (pos >= 0 && pos < word_size && '0' + v[m] > hyphens[pos])
+		hyphens[pos] = '0' + v[m];
+	    }
+	}
+    }
+
+  /* No breaks within lhmin characters of the start or rhmin of the
+     end, nor inside a UTF-8 character. */
+  n_chars = 0;
+  for (i = 0; i < word_size; i++)
+    if (!utf8 || (word[i] & 0xc0) != 0x80)
+      n_chars++;
+  n_before = 0;
+  for (i = 0; i < word_size; i++)
+    {
+      if (!utf8 || (word[i] & 0xc0) != 0x80)
+	n_before++;
+      if (n_before < lhmin || n_chars - n_before < rhmin ||
+	  i == word_size - 1 || (utf8 && (word[i + 1] & 0xc0) == 0x80))
+	hyphens[i] = '0';
+    }
+  return 0;
+}
@@ -0,0 +1,109 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_HYPHTRIE_H__
+#define __HNJ_HYPHTRIE_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _HnjHyphTrie HnjHyphTrie;
+
+/* Compiled hyphenation patterns.
+
+   hnj_hyph_trie_compile turns a pattern file in the format libhyphen
+   loads (a charset line, then one Liang pattern per line) into a
+   trie stored as flat arrays, which hnj_hyph_trie_open maps read-only.
+   Every process opening the same file shares its pages, and a trie
+   may be used by any number of threads at once.
+
+   The file is a sequence of 32-bit words, in the byte order of the
+   machine that wrote it:
+
+     magic, version, flags, lhmin, rhmin, n_nodes, n_edges, n_values,
+     size
+     nodes[n_nodes] (first_edge, n_edges, values each)
+     edges[n_edges]
+     values[n_values], as bytes, padded to a whole word
+
+   Node 0 is the root. The edges of a node are consecutive and sorted
+   by byte; each is the child node shifted left by 8 bits, or'ed with
+   the byte leading to it. The values of a node are the digits of the
+   pattern spelled by the path to it, from the one before its first
+   letter on, with trailing zeros dropped: values is their offset,
+   shifted left by 8 bits, or'ed with their number. All offsets are
+   indices, so the file can be mapped anywhere.
+
+   Patterns after a NEXTLEVEL line (the compound word level of
+   libhyphen) are not compiled, and only the standard part of
+   nonstandard patterns (before the '/') is. */
+
+#define HNJ_HYPH_TRIE_MAGIC 0x54484e48 /* "HNJT" */
+#define HNJ_HYPH_TRIE_VERSION 1
+
+/* In flags: the patterns are in UTF-8. */
+#define HNJ_HYPH_TRIE_UTF8 1
+
+/* Compile the patterns in patterns_fn into trie_fn. Returns 0 on
+   success, -1 if a file can't be read or written, a line is longer
+   than 254 bytes, or out of memory. */
+int hnj_hyph_trie_compile (const char *patterns_fn, const char *trie_fn);
+
+/* Map a compiled trie. Returns NULL if the file can't be read, or is
+   not a trie of this version and byte order. */
+HnjHyphTrie *hnj_hyph_trie_open (const char *filename);
+
+void hnj_hyph_trie_close (HnjHyphTrie *trie);
+
+/* Use a trie already in memory, such as one built into the program.
+   data must stay valid, and be aligned to 4 bytes. */
+HnjHyphTrie *hnj_hyph_trie_new_from_data (const void *data, size_t size);
+
+/* Find the hyphenation points of word, which is word_size bytes long.
+   hyphens must have room for word_size + 1 bytes; hyphens[j] is odd
+   if the word may break after byte j, and hyphens[word_size] is 0.
+   Unlike libhyphen, positions are always counted in bytes, even for
+   UTF-8 patterns. Returns 0. */
+int hnj_hyph_trie_hyphenate (const HnjHyphTrie *trie, const char *word,
+			     int word_size, char *hyphens);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __HNJ_HYPHTRIE_H__ */
@@ -42,6 +42,7 @@ extern "C" {
 
 typedef struct _HnjBreak HnjBreak;
 typedef struct _HnjParams HnjParams;
+typedef struct _HnjLine HnjLine;
 
 /* A potential line break (input to the justification routine).
 
@@ -52,6 +53,12 @@ typedef struct _HnjParams HnjParams;
 
    I'll probably want to put in a "hyphen" flag which causes extra
    penalty if there are two in a row.
+
+   The x0 of the breaks of a paragraph must not decrease; in
+   particular, no hyphen may be wider than the rest of its word.
+   hnj_hs_just copes with breaks out of order by avoiding those that
+   go past a later break, but the other justifiers may return a worse
+   result than the best. penalty must not be negative.
  */
 struct _HnjBreak {
   int x0;
@@ -63,16 +70,71 @@ struct _HnjBreak {
 #define HNJ_JUST_FLAG_ISSPACE 1
 #define HNJ_JUST_FLAG_ISHYPHEN 2
 #define HNJ_JUST_FLAG_ISTAB 4
+/* A hard break must be taken: no line extends past it. */
+#define HNJ_JUST_FLAG_ISHARD 8
+
+/* Flags describing a line of the result. HNJ_JUST_LINE_OVERFULL means
+   the line could not be set within set_width, for example because it
+   holds a single word wider than the line. */
+#define HNJ_JUST_LINE_OVERFULL 1
+
+/* A line of the result, as laid out (output of the *_just_lines
+   functions).
+
+   The line runs from after break start (-1 for the first line) to
+   break end. width is its natural width, with tabs expanded, and
+   n_spaces the number of spaces in it that stretch or shrink: the
+   space breaks after its last tab. stretch is how much those spaces
+   must grow in all to bring the line to set_width; it is negative
+   for lines that shrink. Lines that aren't justified (the last line,
+   and lines ending at hard breaks) only shrink, if they are too
+   long. adjust is stretch / n_spaces, rounded towards zero, or 0 if
+   there are no spaces. penalty is the deviation cost of the line plus
+   the penalty of break end, except for the last line.
+
+   With font expansion (see HnjParams), the glyphs after the last tab
+   are set 1 + expand / 65536 times their natural width, and stretch
+   is what is left for the spaces. expand is 0 otherwise. */
+struct _HnjLine {
+  int start;
+  int end;
+  int width;
+  int n_spaces;
+  int stretch;
+  int adjust;
+  int penalty;
+  int flags;
+  int expand;
+};
 
 /* The justification parameters.
 
+   set_width and tab_width are lengths, in the same units as the x0
+   and x1 of the breaks; the library doesn't care what they are.
+
    max_neg_space is the maximum amount that can be subtracted from a
-   space (i.e. if more is subtracted from a space, the penalty is
+   space, in 256ths of its width: 128 lets spaces shrink to half
+   their width (if more is subtracted from a space, the penalty is
    infinite).
 
    Otherwise, the penalty for a line is simply the square of the
    deviation from the set_width.
 
+   A break flagged HNJ_JUST_FLAG_ISTAB moves the rest of its line to
+   the next multiple of tab_width (1 if zero) from the start of the
+   line. Tabs should be 0 width breaks (x0 = x1).
+
+   max_expand and max_shrink turn on font expansion: the glyphs of a
+   line (everything but its spaces, after its last tab) may be set up
+   to max_expand / 256 wider or max_shrink / 256 narrower. Both are in
+   256ths of the natural width of the glyphs, from 0 to 256; 5 allows
+   about 2% either way. The deviation of a line is then split evenly
+   between its glyphs and its spaces, as far as the glyphs can go, and
+   so that the spaces shrink no more than max_neg_space allows. The penalty is the
+   sum of the squares of the two parts, so a line the glyphs can take
+   half the deviation of costs half as much. Both 0 means no
+   expansion.
+
    This structure will probably grow. For example, extra penalties for
    very short last lines, lists of line lengths (possibly lazy; for
    doing shapes), other junk. But this will do for now.
@@ -82,6 +144,8 @@ struct _HnjParams {
   int set_width;
   int max_neg_space;
   int tab_width;
+  int max_expand;
+  int max_shrink;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,2485 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_JUST_HH__
+#define __HNJ_JUST_HH__
+
+/* Header-only C++ front end to the justifiers.
+
+   The justification algorithms are templates over
+
+   - a cost policy, which decides how much a line costs; see
+     DefaultCost below for the interface,
+   - the storage of the breaks: anything indexable with [] yielding an
+     HnjBreak (or a reference to one), such as a plain array,
+     SoABreaks or PackedBreaks,
+   - the integer type the total penalty is accumulated in.
+
+   so that a custom cost model gets inlined into the search loop
+   instead of needing a fork of the library. hnj_hq_just and
+   hnj_hs_just are instantiations of hq_just and hs_just with
+   DefaultCost and GreedyCost, array storage, and int and long long.
+   hs_just squares the deviation of lines from set_width, which
+   doesn't fit in an int from 46341 units on.
+
+   Define HNJ_USE_PTHREAD before including this file to justify
+   independent segments of big paragraphs on several threads. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h> /* for fprintf debugging output */
+#include <limits.h>
+#include <time.h>
+#ifdef HNJ_USE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include "just.h"
+#include "breakpack.h"
+
+namespace hnj {
+
+/* The cost model of hnj_hq_just. A cost policy provides:
+
+   line<Dist> (dev, brk): the cost of a line ending at brk whose
+     natural width is dev more than set_width. For the search to be
+     correct it must not increase as dev goes up to 0, nor decrease
+     as it goes up from 0, unless justified (brk) is false, in which
+     case it must be constant.
+
+   justified (brk): whether line () depends on dev for lines ending
+     at brk. Only the last break of a paragraph or the break before
+     a hard break may be unjustified.
+
+   penalty<Dist> (brk): the cost of breaking at brk. Must not be
+     negative.
+
+   shrink (total_space, params): how much a line holding total_space
+     worth of spaces may exceed set_width.
+
+   With font expansion, a line costs line (dev - g, brk) + line (g,
+   brk), where g is the part of dev its glyphs take (see glyph_dev
+   below), and may exceed set_width by its glyph_shrink as well. */
+struct DefaultCost
+{
+  static bool
+  justified (const HnjBreak &brk)
+  {
+    return brk.flags & (HNJ_JUST_FLAG_ISHYPHEN | HNJ_JUST_FLAG_ISSPACE |
+			HNJ_JUST_FLAG_ISTAB);
+  }
+
+  template <typename Dist>
+  static Dist
+  line (int dev, const HnjBreak &brk)
+  {
+    if (!justified (brk))
+      return 0;
+    return (Dist) dev * dev;
+  }
+
+  template <typename Dist>
+  static Dist
+  penalty (const HnjBreak &brk)
+  {
+    return brk.penalty;
+  }
+
+  static int
+  shrink (int total_space, const HnjParams *params)
+  {
+    return (int) (((long long) total_space * params->max_neg_space + 0x80) >>
+		  8);
+  }
+};
+
+/* The cost model of hnj_hs_just, which charges for the deviation of
+   every line. */
+struct GreedyCost : DefaultCost
+{
+  static bool
+  justified (const HnjBreak &)
+  {
+    return true;
+  }
+
+  template <typename Dist>
+  static Dist
+  line (int dev, const HnjBreak &)
+  {
+    return (Dist) dev * dev;
+  }
+};
+
+/* Breaks stored as separate arrays of each field. */
+struct SoABreaks
+{
+  const int *x0;
+  const int *x1;
+  const int *penalty;
+  const int *flags;
+
+  HnjBreak
+  operator [] (int i) const
+  {
+    HnjBreak brk;
+
+    brk.x0 = x0[i];
+    brk.x1 = x1[i];
+    brk.penalty = penalty[i];
+    brk.flags = flags[i];
+    return brk;
+  }
+};
+
+#define HNJ_PACKED_CACHE_BLOCKS 8
+
+/* The blocks of HNJ_PACK_BLOCK breaks of an HnjPackedBreaks decoded
+   last, for PackedBreaks. A block goes in slot block %
+   HNJ_PACKED_CACHE_BLOCKS, so a window of some thousand breaks stays
+   decoded. */
+struct PackedCache
+{
+  const HnjPackedBreaks *packed;
+  HnjPackedReader reader;
+  int next_block;
+  int block[HNJ_PACKED_CACHE_BLOCKS];
+  HnjBreak breaks[HNJ_PACKED_CACHE_BLOCKS][HNJ_PACK_BLOCK];
+
+  void
+  init (const HnjPackedBreaks *p)
+  {
+    int i;
+
+    packed = p;
+    hnj_packed_reader_init (&reader, packed, 0);
+    next_block = 0;
+    for (i = 0; i < HNJ_PACKED_CACHE_BLOCKS; i++)
+      block[i] = -1;
+  }
+
+  /* Decode block b into its slot. Runs of blocks in order are read
+     straight on. */
+  void
+  load (int b)
+  {
+    int slot = b % HNJ_PACKED_CACHE_BLOCKS;
+
+    if (b != next_block)
+      hnj_packed_reader_init (&reader, packed, b * HNJ_PACK_BLOCK);
+    hnj_packed_reader_read (&reader, breaks[slot], HNJ_PACK_BLOCK);
+    next_block = b + 1;
+    block[slot] = b;
+  }
+};
+
+/* Breaks decoded from an HnjPackedBreaks as they are used, so that a
+   paragraph is never held decoded whole. Copies share the cache, which
+   must outlive them, and may only be used on one thread at a time. */
+struct PackedBreaks
+{
+  PackedCache *cache;
+
+  HnjBreak
+  operator [] (int i) const
+  {
+    /* i is never negative. */
+    unsigned int b = (unsigned int) i / HNJ_PACK_BLOCK;
+    unsigned int slot = b % HNJ_PACKED_CACHE_BLOCKS;
+
+    if (cache->block[slot] != (int) b)
+      cache->load (b);
+    return cache->breaks[slot][(unsigned int) i % HNJ_PACK_BLOCK];
+  }
+};
+
+/* Font expansion; see HnjParams. glyphs is the width of the glyphs of
+   a line that may be scaled. */
+
+static inline bool
+has_expansion (const HnjParams *params)
+{
+  return params->max_expand != 0 || params->max_shrink != 0;
+}
+
+/* How much glyphs wide may shrink. */
+static inline int
+glyph_shrink (int glyphs, const HnjParams *params)
+{
+  if (glyphs <= 0)
+    return 0;
+  return (int) (((long long) glyphs * params->max_shrink + 0x80) >> 8);
+}
+
+/* The part of the deviation dev of a line that its glyphs take: half,
+   as far as they can go, and more if the spaces would otherwise
+   shrink by more than space_shrink. Negative if the glyphs expand. */
+static inline int
+glyph_dev (int dev, int glyphs, int space_shrink, const HnjParams *params)
+{
+  int limit;
+  int g;
+
+  if (dev < 0)
+    {
+      limit = glyphs <= 0 ? 0 :
+	(int) (((long long) glyphs * params->max_expand + 0x80) >> 8);
+      g = -(-dev >> 1);
+      return g < -limit ? -limit : g;
+    }
+  limit = glyph_shrink (glyphs, params);
+  g = dev >> 1;
+  if (dev - g > space_shrink)
+    g = dev - space_shrink;
+  return g > limit ? limit : g;
+}
+
+/* The cost of a line with deviation dev under Cost, the glyphs taking
+   their part of it. */
+template <typename Cost, typename Dist>
+static inline Dist
+expanded_line (int dev, int glyphs, int space_shrink, const HnjBreak &brk,
+	       const HnjParams *params)
+{
+  int g;
+
+  if (!has_expansion (params))
+    return Cost::template line<Dist> (dev, brk);
+  g = glyph_dev (dev, glyphs, space_shrink, params);
+  return Cost::template line<Dist> (dev - g, brk) +
+    Cost::template line<Dist> (g, brk);
+}
+
+/* The cost of a path through the breaks after start up to end, none
+   of them hard but end, not counting the penalty of end: the path
+   that takes the cheapest feasible line every time. If path isn't
+   NULL, the breaks of the path are stored there and their number in
+   *n_path. The greedy path may get stuck, with no line from a break
+   fitting; the cost is then LLONG_MAX, and the path, if wanted, goes
+   on with an overfull line to the next break. */
+template <typename Cost, typename Breaks>
+long long
+greedy_path (Breaks breaks, const HnjParams *params, int start, int end,
+	     int *path, int *n_path)
+{
+  int tab_width = params->tab_width ? params->tab_width : 1;
+  long long cost = 0;
+  long long d, best_d;
+  int x;
+  int tab_offset;
+  int total_space;
+  int glyph_x;
+  int dev, glyphs, space_shrink;
+  int next_stop;
+  int p, q, best_q;
+  int n = 0;
+
+  for (p = start; p != end; p = best_q)
+    {
+      x = p == -1 ? 0 : breaks[p].x1;
+      tab_offset = 0;
+      total_space = 0;
+      glyph_x = x;
+      best_q = -1;
+      best_d = 0;
+      for (q = p + 1; q <= end; q++)
+	{
+	  dev = breaks[q].x0 + tab_offset - (x + params->set_width);
+	  glyphs = breaks[q].x0 - glyph_x - total_space;
+	  space_shrink = Cost::shrink (total_space, params);
+	  if (dev > space_shrink + glyph_shrink (glyphs, params))
+	    break;
+	  d = expanded_line<Cost, long long> (dev, glyphs, space_shrink,
+					      breaks[q], params);
+	  if (q != end)
+	    d += Cost::template penalty<long long> (breaks[q]);
+	  if (best_q == -1 || d <= best_d)
+	    {
+	      best_q = q;
+	      best_d = d;
+	    }
+	  if (breaks[q].flags & HNJ_JUST_FLAG_ISTAB)
+	    {
+	      next_stop = ((breaks[q].x0 + tab_offset - x) / tab_width + 1) *
+		tab_width;
+	      tab_offset = x + next_stop - breaks[q].x0;
+	      total_space = 0;
+	      glyph_x = breaks[q].x1;
+	    }
+	  if (breaks[q].flags & HNJ_JUST_FLAG_ISSPACE)
+	    total_space += breaks[q].x1 - breaks[q].x0;
+	}
+      if (best_q == -1)
+	{
+	  if (path == NULL)
+	    return LLONG_MAX;
+	  best_q = p + 1;
+	  cost = LLONG_MAX;
+	}
+      else if (best_d >= LLONG_MAX - cost)
+	cost = LLONG_MAX;
+      else
+	cost += best_d;
+      if (path != NULL)
+	path[n++] = best_q;
+    }
+  if (n_path != NULL)
+    *n_path = n;
+  return cost;
+}
+
+/* Fill in the rest of line, whose start, end, width, n_spaces and
+   flags are set, given the width of the spaces in it that may shrink
+   (total_space) and of the glyphs that may be scaled. last tells
+   whether it is the last line of the paragraph, whose end isn't
+   charged for. */
+template <typename Cost, typename Dist>
+void
+finish_line_record (const HnjBreak &brk, const HnjParams *params,
+		    int total_space, int glyphs, bool last, HnjLine *line)
+{
+  int dev, g;
+  long long penalty;
+
+  dev = line->width - params->set_width;
+  g = 0;
+  if (has_expansion (params) && (dev > 0 || Cost::justified (brk)))
+    g = glyph_dev (dev, glyphs, Cost::shrink (total_space, params), params);
+  line->expand = g ? (int) (-(long long) g * 65536 / glyphs) : 0;
+  line->stretch = g - dev;
+  if (!Cost::justified (brk) && line->stretch > 0)
+    line->stretch = 0;
+  line->adjust = line->n_spaces ? line->stretch / line->n_spaces : 0;
+
+  penalty = expanded_line<Cost, Dist> (dev, glyphs,
+				       Cost::shrink (total_space, params),
+				       brk, params);
+  if (!last)
+    penalty += Cost::template penalty<Dist> (brk);
+  line->penalty = penalty > INT_MAX ? INT_MAX : (int) penalty;
+
+  if (line->stretch < -Cost::shrink (total_space, params))
+    line->flags |= HNJ_JUST_LINE_OVERFULL;
+}
+
+/* Fill in line with the layout of the line from break start (-1 for
+   the first line) to break end, in a pass over the breaks of the
+   line. flags are the HNJ_JUST_LINE_* flags it was returned with;
+   it is flagged overfull if it is too long to fit either way. Costs
+   are worked out with Cost. */
+template <typename Cost, typename Dist, typename Breaks>
+void
+line_record (Breaks breaks, const HnjParams *params, int start, int end,
+	     int flags, bool last, HnjLine *line)
+{
+  int tab_width = params->tab_width ? params->tab_width : 1;
+  int x = start == -1 ? 0 : breaks[start].x1;
+  int tab_offset = 0;
+  int total_space = 0;
+  int glyph_x = x;
+  int next_stop;
+  int i;
+
+  line->start = start;
+  line->end = end;
+  line->n_spaces = 0;
+  for (i = start + 1; i < end; i++)
+    {
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISTAB)
+	{
+	  next_stop = ((breaks[i].x0 + tab_offset - x) / tab_width + 1) *
+	    tab_width;
+	  tab_offset = x + next_stop - breaks[i].x0;
+	  line->n_spaces = 0;
+	  total_space = 0;
+	  glyph_x = breaks[i].x1;
+	}
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISSPACE)
+	{
+	  line->n_spaces++;
+	  total_space += breaks[i].x1 - breaks[i].x0;
+	}
+    }
+  line->width = breaks[end].x0 + tab_offset - x;
+  line->flags = flags;
+  finish_line_record<Cost, Dist> (breaks[end], params, total_space,
+				  breaks[end].x0 - glyph_x - total_space,
+				  last, line);
+}
+
+/* A limit on the work of a search, for hq_just. work is the number of
+   steps of the search left, or -1 for no limit, and deadline a
+   CLOCK_MONOTONIC time in nanoseconds to stop at, or 0 for none.
+   steps counts the steps taken, and exhausted is set once the search
+   has run out. */
+struct Budget
+{
+  long work;
+  long long deadline;
+  long steps;
+  bool exhausted;
+};
+
+/* Entries are taken off the front of the queue of a search, and the
+   rest moved down once at least this many, and half the queue, are
+   gone; so the queue only takes as much memory as it holds at once. */
+#define HNJ_QUEUE_COMPACT 1024
+
+/* Paragraphs with fewer breaks than this are always justified on the
+   calling thread; starting threads costs more than it saves. */
+#define HNJ_PARALLEL_MIN_BREAKS 4096
+#define HNJ_MAX_THREADS 64
+
+/* To give threads work, segments are cut into pieces of about
+   HNJ_PIECES_PER_THREAD per thread, and no fewer than HNJ_MIN_PIECE
+   breaks; there are no more threads than pieces of that size. A cut
+   is looked for among paths from as many as HNJ_CUT_MAX_WIDTH breaks
+   before where a piece should end, taking up to HNJ_CUT_WORK steps
+   for each break of the piece, where a step of the search takes
+   several hundred. The paths from the breaks of a line take about
+   HNJ_CUT_MERGE lines for each of those breaks to meet; if the
+   steps wouldn't last that long, there is no looking. */
+#define HNJ_PIECES_PER_THREAD 2
+#define HNJ_MIN_PIECE 1024
+#define HNJ_CUT_MAX_WIDTH 256
+#define HNJ_CUT_WORK 512
+#define HNJ_CUT_MERGE 6
+
+/* High quality justification.
+
+   This justifies an entire paragraph at a time. The input is a series
+   of potential line breaks, as well as a set width. In the future, the
+   set width may be implemented as a list of widths, one for each line,
+   to support non-rectangular paragraphs.
+
+   The basic approach is to use Dijkstra's shortest path graph
+   algorithm to find the sequence of line breaks that results in
+   least overall penalty for the paragraph. Each line break has its
+   own penalty, and each line also has a penalty which depends on
+   the variation from the ideal set width.
+
+   A tab moves the rest of its line to the next multiple of tab_width
+   from the start of the line, the same as in hs_just. */
+template <typename Cost, typename Breaks, typename Dist = int>
+class HqJust
+{
+public:
+  HqJust (Breaks breaks, int n_breaks, const HnjParams *params)
+    : breaks (breaks), n_breaks (n_breaks), params (params),
+      tab_width (params->tab_width ? params->tab_width : 1),
+      expand (has_expansion (params)),
+      tab_rank (NULL), tab_idx (NULL), budget (NULL), max_threads (0),
+      lines (NULL)
+  {
+  }
+
+  /* Use up to n threads, whatever the number of processors, or one
+     per processor if n is negative. 0, the default, uses one per
+     processor for paragraphs of at least HNJ_PARALLEL_MIN_BREAKS
+     breaks only. There are never more threads than pieces of
+     HNJ_MIN_PIECE breaks, and fewer are used if the paragraph can't
+     be cut into enough pieces. Without HNJ_USE_PTHREAD this has no
+     effect. */
+  void
+  set_max_threads (int n)
+  {
+    max_threads = n;
+  }
+
+  /* Stop searching when budget runs out, and make do with the best
+     path found by then. */
+  void
+  set_budget (Budget *b)
+  {
+    budget = b;
+  }
+
+  /* Also fill in lines with the layout of each line of the result, as
+     line_records with Cost would, while reading out the best path.
+     l must have room for n_breaks entries. */
+  void
+  set_lines (HnjLine *l)
+  {
+    lines = l;
+  }
+
+  int run (int *result, int *result_flags);
+
+private:
+  /* Scratch area for each break. dist is the minimum distance (i.e.
+     total penalty so far) from the beginning of the paragraph to this
+     break, based on edges already visited (or INF if the break has
+     not yet been visited. pred is the predecessor of this break on
+     such a shortest distance sequence. This is kept to what every
+     break needs, as there is one per break of the longest segment;
+     where the scans from a break have got to is kept in their queue
+     entries. */
+  struct Scratch {
+    Dist dist;
+    int total_space;
+    int pred;
+  };
+
+  /* The tabs on the lines of a segment, only kept for paragraphs with
+     tabs. For a line starting at break p, the offsets the tabs on it
+     add to the breaks following them are pool[base[p]], pool[base[p]
+     + 1], ... for the first n_tab[p] tabs. Tabs after those don't fit
+     on the line. base and n_tab are indexed like the scratch. */
+  struct Tabs {
+    int *pool;
+    int n_pool;
+    int pool_size;
+    int *base;
+    int *n_tab;
+  };
+
+  enum QueueType {
+    Q_VISIT,
+    Q_LEFT,
+    Q_RIGHT
+  };
+
+  /* For a scan, next is the break in the next line it gets to next.
+     Left scans go down from the least deviation from the ideal line
+     width, and right scans up from just past it, so all the breaks
+     between the two have been visited. */
+  struct QueueEntry {
+    Dist dist;
+    int break_idx;
+    QueueType type;
+    int next;
+  };
+
+  /* A run of breaks that can be justified independently of the rest
+     of the paragraph: a best path through the paragraph passes through
+     both start and end. */
+  struct Segment {
+    int start;
+    int end;
+    int flags; /* HNJ_JUST_LINE_* flags, for forced single lines */
+    int n_result;
+  };
+
+#ifdef HNJ_USE_PTHREAD
+  struct Worker {
+    pthread_t thread;
+    const HqJust *just;
+    Segment *segs;
+    int n_segs;
+    int first_seg;
+    int n_thread;
+    int *result;
+    int status;
+  };
+
+  /* A cut for cut_segments to look for after c, in the segment from
+     start to end. */
+  struct Cut {
+    int start;
+    int end;
+    int c;
+    int cut;
+  };
+
+  struct CutWorker {
+    pthread_t thread;
+    const HqJust *just;
+    Cut *cuts;
+    int n_cuts;
+    int first_cut;
+    int n_thread;
+    int piece;
+  };
+#endif
+
+  static const Dist INF = (Dist) ((((unsigned long long) 1) <<
+				   (sizeof (Dist) * CHAR_BIT - 1)) - 1);
+
+  Breaks breaks;
+  int n_breaks;
+  const HnjParams *params;
+  int tab_width;
+  bool expand;
+  /* When the paragraph has tabs, tab_rank[i] is the number of tabs
+     before break i, and tab_idx[r] the index of tab r. Both are NULL
+     otherwise. */
+  int *tab_rank;
+  int *tab_idx;
+  Budget *budget;
+  int max_threads;
+  HnjLine *lines;
+
+  int
+  x_after (int break_idx) const
+  {
+    return break_idx == -1 ? 0 : breaks[break_idx].x1;
+  }
+
+  /* The layout of the n lines of res, which start after break start,
+     for paths the search didn't work out. */
+  void
+  fill_lines (int start, const int *res, int n, HnjLine *line) const
+  {
+    int i;
+
+    for (i = 0; i < n; i++)
+      line_record<Cost, long long> (breaks, params, i ? res[i - 1] : start,
+				    res[i], 0, res[i] == n_breaks - 1,
+				    &line[i]);
+  }
+
+  /* Return the end of a line from break p to break q with the tabs
+     on it expanded, or INT_MAX if one of those tabs doesn't fit on the
+     line. *space_base is set to the break after which the space that
+     may shrink starts: the break before the last tab, or p. */
+  int
+  line_x0 (const Tabs *tabs, int p, int q, int *space_base) const
+  {
+    int n_tab;
+
+    *space_base = p;
+    if (tab_rank == NULL)
+      return breaks[q].x0;
+    n_tab = tab_rank[q] - tab_rank[p + 1];
+    if (n_tab == 0)
+      return breaks[q].x0;
+    if (n_tab > tabs->n_tab[p])
+      return INT_MAX;
+    *space_base = tab_idx[tab_rank[q] - 1] - 1;
+    return breaks[q].x0 + tabs->pool[tabs->base[p] + n_tab - 1];
+  }
+
+  /* The width of the glyphs that may be scaled on a line starting at
+     x and ending at break q: those after the tab following space_base
+     (see line_x0), if there is one on the line, up to q. */
+  int
+  line_glyphs (const Scratch *s, int x, int q, int space_base) const
+  {
+    if (space_base + 1 < q &&
+	(breaks[space_base + 1].flags & HNJ_JUST_FLAG_ISTAB))
+      x = breaks[space_base + 1].x1;
+    return breaks[q].x0 - x -
+      (s[q - 1].total_space - s[space_base].total_space);
+  }
+
+  /* The layout of the line from break p to break q of the best path,
+     from what the search worked out about it: only its spaces are
+     counted again. */
+  void
+  path_line (const Scratch *s, const Tabs *tabs, int p, int q,
+	     HnjLine *line) const
+  {
+    int x = x_after (p);
+    int space_base;
+    int i;
+
+    line->start = p;
+    line->end = q;
+    line->width = line_x0 (tabs, p, q, &space_base) - x;
+    line->n_spaces = 0;
+    for (i = space_base + 1; i < q; i++)
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISSPACE)
+	line->n_spaces++;
+    line->flags = 0;
+    finish_line_record<Cost, long long>
+      (breaks[q], params, s[q - 1].total_space - s[space_base].total_space,
+       line_glyphs (s, x, q, space_base), q == n_breaks - 1, line);
+  }
+
+  /* Whether a line from break p, which ends at x, to break q doesn't
+     shrink more than max_neg_space (and max_shrink) allow. */
+  bool
+  line_fits (const Scratch *s, const Tabs *tabs, int x, int p,
+	     int q) const
+  {
+    int space_base;
+    int x0 = line_x0 (tabs, p, q, &space_base);
+    int limit;
+
+    if (x0 == INT_MAX)
+      return false;
+    limit = x + params->set_width +
+      Cost::shrink (s[q - 1].total_space - s[space_base].total_space,
+		    params);
+    if (expand)
+      limit += glyph_shrink (line_glyphs (s, x, q, space_base), params);
+    return x0 <= limit;
+  }
+
+  /* Compute the offsets of the tabs on a line starting at break p,
+     which ends at x, storing them at the end of the tab pool. Tabs
+     are looked at up to end. Returns -1 if out of memory. */
+  int
+  tab_offsets (const Scratch *s, Tabs *tabs, int x, int p, int end) const
+  {
+    int offset = 0;
+    int space_base = p;
+    int next_stop;
+    int r;
+    int t;
+
+    tabs->base[p] = tabs->n_pool;
+    tabs->n_tab[p] = 0;
+    for (r = tab_rank[p + 1]; r < tab_rank[end + 1]; r++)
+      {
+	t = tab_idx[r];
+	if (breaks[t].x0 + offset > x + params->set_width +
+	    Cost::shrink (s[t - 1].total_space - s[space_base].total_space,
+			  params) +
+	    (expand ? glyph_shrink (line_glyphs (s, x, t, space_base),
+				    params) : 0))
+	  break;
+	if (tabs->n_pool == tabs->pool_size)
+	  {
+	    int *new_pool;
+
+	    new_pool = (int *) realloc (tabs->pool, (tabs->pool_size * 2 + 16) *
+					sizeof (int));
+	    if (new_pool == NULL)
+	      return -1;
+	    tabs->pool = new_pool;
+	    tabs->pool_size = tabs->pool_size * 2 + 16;
+	  }
+	next_stop = ((breaks[t].x0 + offset - x) / tab_width + 1) * tab_width;
+	offset = x + next_stop - breaks[t].x0;
+	tabs->pool[tabs->n_pool++] = offset;
+	tabs->n_tab[p]++;
+	space_base = t - 1;
+      }
+    return 0;
+  }
+
+  /* Find the point at which deviation stops decreasing and starts
+     increasing. For the returned break, the line is just too short,
+     and for the next break, just too long. x is the position of the
+     start of the line, and breaks are looked at up to end. */
+  int
+  find_min_dev_pt (const Tabs *tabs, int x, int break_idx, int end) const
+  {
+    int x_target = x + params->set_width;
+    int space_base;
+    int i;
+
+    for (i = break_idx + 1; i <= end; i++)
+      if (line_x0 (tabs, break_idx, i, &space_base) > x_target)
+	break;
+    return i - 1;
+  }
+
+  /* Return the cost of the deviation for a line from break p, which
+     ends at x, to break q. This is one component of the penalty for
+     a break (the other being the penalty field stored in the break
+     itself). The line must fit. */
+  Dist
+  dev2 (const Scratch *s, const Tabs *tabs, int x, int p, int q) const
+  {
+    int space_base;
+    int dev = line_x0 (tabs, p, q, &space_base) -
+      (x + params->set_width);
+
+    if (!expand)
+      return Cost::template line<Dist> (dev, breaks[q]);
+    return expanded_line<Cost, Dist>
+      (dev, line_glyphs (s, x, q, space_base),
+       Cost::shrink (s[q - 1].total_space - s[space_base].total_space,
+		     params),
+       breaks[q], params);
+  }
+
+  /* The key a scan is queued at for the line from p to q: a lower
+     bound on dev2 that doesn't decrease as the scan moves away from
+     the minimum deviation point. With font expansion dev2 itself
+     needn't, as the glyphs before a tab can't be scaled, so a left
+     scan crossing a tab may find cheaper lines; the cost with glyphs
+     that scale without limit depends only on the deviation. */
+  Dist
+  scan_dev2 (const Scratch *s, const Tabs *tabs, int x, int p,
+	     int q) const
+  {
+    int space_base;
+    int dev;
+    int g;
+
+    if (!expand)
+      return dev2 (s, tabs, x, p, q);
+    dev = line_x0 (tabs, p, q, &space_base) -
+      (x + params->set_width);
+    g = dev < 0 ? -(-dev >> 1) : dev >> 1;
+    return Cost::template line<Dist> (dev - g, breaks[q]) +
+      Cost::template line<Dist> (g, breaks[q]);
+  }
+
+  /* a + b, or INF if that's out of range. */
+  static Dist
+  add_dist (Dist a, Dist b)
+  {
+    return a >= INF - b ? INF : a + b;
+  }
+
+  /* Whether the line from p, which starts at x, to q would bring q
+     closer than it is, with base the distance of p plus its
+     penalty. */
+  bool
+  improves (const Scratch *s, const Tabs *tabs, int x, int p, int q,
+	    Dist base) const
+  {
+    return add_dist (base, dev2 (s, tabs, x, p, q)) < s[q].dist;
+  }
+
+  /* Take a step of the search out of the budget, if there is one.
+     Returns whether it has run out. The clock is only read every 64
+     steps. */
+  bool
+  budget_spent () const
+  {
+    struct timespec ts;
+
+    if (budget == NULL)
+      return false;
+    if (budget->exhausted || budget->work == 0)
+      {
+	budget->exhausted = true;
+	return true;
+      }
+    if (budget->work > 0)
+      budget->work--;
+    if (budget->deadline && (budget->steps & 63) == 0)
+      {
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	if (ts.tv_sec * 1000000000LL + ts.tv_nsec >= budget->deadline)
+	  budget->exhausted = true;
+      }
+    budget->steps++;
+    return budget->exhausted;
+  }
+
+  /* Free up ins_pt for insertion, q_end increments */
+  static void
+  queue_insert (QueueEntry *queue, int ins_pt, int q_end)
+  {
+    int i;
+
+    for (i = q_end; i > ins_pt; i--)
+      queue[i] = queue[i - 1];
+  }
+
+  /* Insert based on distance, return ins point, q_end increments */
+  static int
+  queue_insert_dist (QueueEntry *queue, Dist dist, int q_beg, int q_end)
+  {
+    int ins_pt;
+
+    for (ins_pt = q_beg; ins_pt < q_end; ins_pt++)
+      if (queue[ins_pt].dist > dist)
+	break;
+    queue_insert (queue, ins_pt, q_end);
+    return ins_pt;
+  }
+
+  /* Change the dist on queue[pos] to dist, maintaining the queue
+     invariant. */
+  static void
+  queue_move (QueueEntry *queue,
+	      Dist old_dist, int break_idx, QueueType type,
+	      Dist dist, int q_beg, int q_end)
+  {
+    QueueEntry tmp;
+    int i;
+    int pos;
+
+    for (pos = q_beg; pos < q_end; pos++)
+      if (queue[pos].dist == old_dist && queue[pos].break_idx == break_idx &&
+	  queue[pos].type == type)
+	break;
+
+    if (pos == q_end)
+      {
+	/* Only breaks whose x0 go backwards (see just.h) get here. The
+	   result may then be worse than the best, but the search still
+	   finishes. */
+#ifdef VERBOSE
+	fprintf (stderr, "queue_move: not found!\n");
+#endif
+	return;
+      }
+
+    tmp = queue[pos];
+    if (pos > q_beg && queue[pos - 1].dist > dist)
+      {
+	/* it moves to the left */
+	for (i = pos; i > q_beg && queue[i - 1].dist > dist; i--)
+	  queue[i] = queue[i - 1];
+      }
+    else
+      {
+	/* it moves to the right */
+	for (i = pos; i + 1 < q_end && queue[i + 1].dist < dist; i++)
+	  queue[i] = queue[i + 1];
+      }
+    tmp.dist = dist;
+    queue[i] = tmp;
+  }
+
+  /* Take the entry for a scan off the front of the queue, q_beg
+     increments. Visits queued while relaxing its line may have gone
+     ahead of it if the x0 of the breaks go backwards; those stay. */
+  static void
+  queue_remove (QueueEntry *queue, Dist old_dist, int break_idx,
+		QueueType type, int q_beg, int q_end)
+  {
+    int pos;
+
+    for (pos = q_beg; pos < q_end; pos++)
+      if (queue[pos].dist == old_dist && queue[pos].break_idx == break_idx &&
+	  queue[pos].type == type)
+	break;
+    if (pos == q_end)
+      pos = q_beg;
+    for (; pos > q_beg; pos--)
+      queue[pos] = queue[pos - 1];
+  }
+
+  /* Record that break new_break_idx can be reached at total penalty
+     new_dist by way of break pred, queueing a visit to it. */
+  static void
+  relax (QueueEntry *queue, Scratch *s, int q_beg, int *q_end,
+	 int new_break_idx, Dist new_dist, int pred)
+  {
+    int ins_pt;
+
+    if (s[new_break_idx].dist == INF)
+      {
+#ifdef VERBOSE
+	fprintf (stderr, "inserting %d at dist %lld\n",
+		 new_break_idx, (long long) new_dist);
+#endif
+	ins_pt = queue_insert_dist (queue, new_dist, q_beg, (*q_end)++);
+	queue[ins_pt].dist = new_dist;
+	queue[ins_pt].break_idx= new_break_idx;
+	queue[ins_pt].type = Q_VISIT;
+	s[new_break_idx].dist = new_dist;
+	s[new_break_idx].pred = pred;
+      }
+    else if (new_dist < s[new_break_idx].dist)
+      {
+#ifdef VERBOSE
+	fprintf (stderr, "reducing %d dist from %lld to %lld\n",
+		 new_break_idx, (long long) s[new_break_idx].dist,
+		 (long long) new_dist);
+#endif
+	queue_move (queue, s[new_break_idx].dist, new_break_idx, Q_VISIT,
+		    new_dist, q_beg, *q_end);
+	s[new_break_idx].dist = new_dist;
+	s[new_break_idx].pred = pred;
+      }
+  }
+
+  int just_segment (int start, int end, Scratch *scratch,
+		    QueueEntry *queue, Tabs *tabs, int *result) const;
+  int find_segments (Segment *segs) const;
+  int just_segments (Segment *segs, int n_segs, int first_seg,
+		     int n_thread, int *result) const;
+#ifdef HNJ_USE_PTHREAD
+  int find_cut (int start, int end, int c, int piece) const;
+  void find_cuts (Cut *cuts, int n_cuts, int first_cut, int n_thread,
+		  int piece) const;
+  static void *cut_worker (void *data);
+  int cut_segments (Segment **segs, int n_segs, int n_thread) const;
+  static void *segment_worker (void *data);
+  int just_segments_threaded (Segment *segs, int n_segs, int n_thread,
+			      int *result) const;
+  int get_n_thread () const;
+#endif
+};
+
+/* Justify one segment of the paragraph: the breaks after start (-1
+   for the beginning of the paragraph) up to and including end. The
+   last break of the segment is always chosen, and every break in the
+   segment must be reachable by feasible lines; find_segments sets
+   segments up this way.
+
+   This is a plain Dijkstra search, not A*. Lower bounds on the cost
+   of the rest of a segment are too loose to prune: for any point of
+   the segment, some line over it nearly fits set_width and costs next
+   to nothing, and space breaks have no penalty. The best bound tried,
+   summing the cheapest line over each of a chain of points no line
+   gets past two of, came to a few percent of the real cost and saved
+   under 0.2% of the steps.
+
+   scratch must hold at least end - start + 1 entries and queue at
+   least 3 * (end - start) + 1. The tab pool grows as needed. The
+   return value is the number of results written, which are indices
+   into breaks, or -1 if out of memory. */
+template <typename Cost, typename Breaks, typename Dist>
+int
+HqJust<Cost, Breaks, Dist>::just_segment (int start, int end,
+					  Scratch *scratch,
+					  QueueEntry *queue,
+					  Tabs *tabs,
+					  int *result) const
+{
+  Scratch *s;
+  int i;
+  int min_dev_pt;
+  int q_beg, q_end;
+  Dist key;
+  Dist dist;
+  int break_idx;
+  int x_prev;
+  Dist new_dist;
+  Dist base;
+  int new_break_idx;
+  int next;
+  int ins_pt;
+  QueueType type;
+  int n_result;
+  int total_space;
+  int scan_end;
+  int far_visit;
+  long long greedy, spliced;
+  int n_greedy;
+
+  /* Scratch is indexed relative to the start of the segment. */
+  s = scratch - start; /* so that s[start] is valid */
+
+  /* Right scans stop short of the last break if it isn't justified;
+     see below. */
+  scan_end = end + 1;
+  if (!Cost::justified (breaks[end]))
+    scan_end = end;
+
+  total_space = 0;
+  for (i = start + 1; i <= end; i++)
+    {
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISSPACE)
+	total_space += breaks[i].x1 - breaks[i].x0;
+      s[i].total_space = total_space;
+      s[i].dist = INF;
+      s[i].pred = -1;
+    }
+
+  s[start].total_space = 0;
+  s[start].dist = 0;
+  s[start].pred = -1;
+  if (tabs)
+    tabs->n_pool = 0;
+
+  q_beg = 0;
+  q_end = 1;
+  queue[0].dist = 0;
+  queue[0].break_idx = start;
+  queue[0].type = Q_VISIT;
+  far_visit = start;
+
+  while (q_beg != q_end) {
+    if (budget_spent ())
+      goto out_of_budget;
+    if (q_beg >= HNJ_QUEUE_COMPACT && q_beg >= q_end - q_beg)
+      {
+	memmove (queue, queue + q_beg, (q_end - q_beg) * sizeof (QueueEntry));
+	q_end -= q_beg;
+	q_beg = 0;
+      }
+    key = queue[q_beg].dist;
+    break_idx = queue[q_beg].break_idx;
+    type = queue[q_beg].type;
+    dist = s[break_idx].dist;
+    switch (type) {
+    case Q_VISIT:
+      if (break_idx == end)
+	/* Reached the end! */
+	goto done;
+      q_beg++;
+      x_prev = x_after (break_idx);
+      if (break_idx > far_visit)
+	far_visit = break_idx;
+
+      if (tab_rank != NULL &&
+	  tab_offsets (s, tabs, x_prev, break_idx, end))
+	return -1;
+
+      min_dev_pt = find_min_dev_pt (tabs, x_prev, break_idx, end);
+
+      /* The penalty of the break the segment starts at is the same
+	 for every path, so it is left out. */
+      base = dist;
+      if (break_idx != start)
+	base += Cost::template penalty<Dist> (breaks[break_idx]);
+
+      /* insert left scan, skipping lines that don't help (see below) */
+      next = min_dev_pt;
+      while (next > break_idx &&
+	     !improves (s, tabs, x_prev, break_idx, next, base))
+	next--;
+      if (next > break_idx)
+	{
+	  new_dist = add_dist (dist, scan_dev2 (s, tabs, x_prev,
+						break_idx, next));
+	  ins_pt = queue_insert_dist (queue, new_dist, q_beg, q_end++);
+	  queue[ins_pt].dist = new_dist;
+	  queue[ins_pt].break_idx = break_idx;
+	  queue[ins_pt].type = Q_LEFT;
+	  queue[ins_pt].next = next;
+	}
+
+      /* insert right scan, likewise */
+      next = min_dev_pt + 1;
+      while (next < scan_end &&
+	     line_fits (s, tabs, x_prev, break_idx, next) &&
+	     !improves (s, tabs, x_prev, break_idx, next, base))
+	next++;
+      if (next < scan_end && line_fits (s, tabs, x_prev, break_idx, next))
+	{
+	  new_dist = add_dist (dist, scan_dev2 (s, tabs, x_prev,
+						break_idx, next));
+	  ins_pt = queue_insert_dist (queue, new_dist, q_beg, q_end++);
+	  queue[ins_pt].dist = new_dist;
+	  queue[ins_pt].break_idx = break_idx;
+	  queue[ins_pt].type = Q_RIGHT;
+	  queue[ins_pt].next = next;
+	}
+
+      /* A line ending at an unjustified end of the segment has no
+	 deviation penalty, so unlike the rest of the right scan it
+	 doesn't get more expensive the further it is from min_dev_pt.
+	 Reach it right away, so it isn't visited before the right scan
+	 gets to it. */
+      if (scan_end <= end && min_dev_pt < end &&
+	  line_fits (s, tabs, x_prev, break_idx, end))
+	{
+	  new_dist = base + dev2 (s, tabs, x_prev, break_idx, end);
+	  relax (queue, s, q_beg, &q_end, end, new_dist, break_idx);
+	}
+
+#ifdef VERBOSE
+      fprintf (stderr, "visit %d, dist %lld, pred %d, min_dev_pt = %d\n",
+	       break_idx, (long long) dist, s[break_idx].pred, min_dev_pt);
+#endif
+      break;
+    case Q_LEFT:
+    case Q_RIGHT:
+      new_break_idx = queue[q_beg].next;
+      x_prev = x_after (break_idx);
+      base = dist;
+      if (break_idx != start)
+	base += Cost::template penalty<Dist> (breaks[break_idx]);
+      new_dist = base + dev2 (s, tabs, x_prev, break_idx, new_break_idx);
+#ifdef VERBOSE
+      fprintf (stderr, "%s scan %d, new_break_idx = %d\n",
+	       type == Q_LEFT ? "left": "right", break_idx, new_break_idx);
+#endif
+      /* Move the scan on before relaxing, which may queue visits
+	 ahead of it. Lines that wouldn't improve on the distance of the
+	 break they end at are skipped. Most of those a scan meets end
+	 at breaks already visited through lines closer to set_width.
+	 Otherwise, from early in a long paragraph, scans would go on
+	 to lines ever further from set_width until they cost as much
+	 as the whole paragraph, and stay queued meanwhile, so that the
+	 queue grew with the paragraph. */
+      if (type == Q_LEFT)
+	{
+	  next = new_break_idx - 1;
+	  while (next > break_idx &&
+		 !improves (s, tabs, x_prev, break_idx, next, base))
+	    next--;
+	}
+      else /* type == Q_RIGHT */
+	{
+	  next = new_break_idx + 1;
+	  while (next < scan_end &&
+		 line_fits (s, tabs, x_prev, break_idx, next) &&
+		 !improves (s, tabs, x_prev, break_idx, next, base))
+	    next++;
+	  if (next >= scan_end || !line_fits (s, tabs, x_prev, break_idx, next))
+	    next = end + 1;
+	}
+      queue[q_beg].next = next;
+      relax (queue, s, q_beg, &q_end, new_break_idx, new_dist, break_idx);
+      if (next > break_idx && next <= end)
+	queue_move (queue, key, break_idx, type,
+		    add_dist (dist, scan_dev2 (s, tabs, x_prev, break_idx,
+					       next)),
+		    q_beg, q_end);
+      else
+	/* The scan is over. */
+	queue_remove (queue, key, break_idx, type, q_beg++, q_end);
+      break;
+    }
+  }
+
+  /* The queue ran dry without reaching the end of the segment, which
+     can't happen for a segment set up by find_segments. Just set
+     the whole segment as one line rather than reading out garbage. */
+  result[0] = end;
+  if (lines)
+    fill_lines (start, result, 1, lines + start + 1);
+  return 1;
+
+out_of_budget:
+  /* The best path to the furthest break visited is known. Follow it
+     with the greedy path from there, if that beats the greedy path
+     through the whole segment. */
+  greedy = greedy_path<Cost, Breaks> (breaks, params, start, end, NULL, NULL);
+  spliced = LLONG_MAX;
+  if (far_visit != start)
+    {
+      spliced = greedy_path<Cost, Breaks> (breaks, params, far_visit, end,
+					   NULL, NULL);
+      if (spliced < LLONG_MAX - s[far_visit].dist -
+	  Cost::template penalty<long long> (breaks[far_visit]))
+	spliced += s[far_visit].dist +
+	  Cost::template penalty<long long> (breaks[far_visit]);
+      else
+	spliced = LLONG_MAX;
+    }
+#ifdef VERBOSE
+  fprintf (stderr, "out of budget: greedy %lld, via %d %lld\n", greedy,
+	   far_visit, spliced);
+#endif
+  if (spliced >= greedy)
+    {
+      greedy_path<Cost, Breaks> (breaks, params, start, end, result,
+				 &n_greedy);
+      if (lines)
+	fill_lines (start, result, n_greedy, lines + start + 1);
+      return n_greedy;
+    }
+  break_idx = far_visit;
+  for (n_result = 0; break_idx != start; break_idx = s[break_idx].pred)
+    n_result++;
+  for (i = n_result - 1, break_idx = far_visit; i >= 0; i--)
+    {
+      result[i] = break_idx;
+      break_idx = s[break_idx].pred;
+    }
+  greedy_path<Cost, Breaks> (breaks, params, far_visit, end,
+			     result + n_result, &n_greedy);
+  if (lines)
+    fill_lines (start, result, n_result + n_greedy, lines + start + 1);
+  return n_result + n_greedy;
+
+done:
+  /* Read out the results (in reverse order), and the layout of their
+     lines if wanted. */
+  for (n_result = 0; break_idx != start; break_idx = s[break_idx].pred)
+    n_result++;
+
+  break_idx = end;
+  for (i = n_result - 1; i >= 0; i--)
+    {
+#ifdef VERBOSE
+      fprintf (stderr, " %d", break_idx);
+#endif
+      result[i] = break_idx;
+      if (lines)
+	path_line (s, tabs, s[break_idx].pred, break_idx,
+		   &lines[start + 1 + i]);
+      break_idx = s[break_idx].pred;
+    }
+#ifdef VERBOSE
+  fprintf (stderr, "\n");
+#endif
+
+  return n_result;
+}
+
+/* Find the segments of the paragraph, in a single pass over the
+   breaks. Segments end at hard breaks, at breaks no feasible line can
+   get past (cut points), and around material that doesn't fit on a
+   line at all, which gets an overfull line of its own. Returns the
+   number of segments. */
+template <typename Cost, typename Breaks, typename Dist>
+int
+HqJust<Cost, Breaks, Dist>::find_segments (Segment *segs) const
+{
+  int n_segs;
+  int start;
+  int i;
+  int next, far;
+  int x_prev;
+  int total_space;
+  int tab_offset;
+  int glyph_x;
+  int next_stop;
+  int set_width = params->set_width;
+
+  n_segs = 0;
+  start = -1;
+  /* next is the first break not yet known to be reachable on a line
+     starting at break i, total_space the space between i (or the last
+     tab) and next, tab_offset the offset the tabs before next give it,
+     and far the furthest break reachable from any break before i. As
+     long as a line can't shrink by more than the space and glyphs in
+     it, next never moves backwards and the scan is linear, except
+     that tab stops depend on where the line starts, so lines with
+     tabs are scanned afresh. glyph_x is where the glyphs that may be
+     scaled start: at the line or after its last tab. */
+  next = 0;
+  total_space = 0;
+  tab_offset = 0;
+  far = -1;
+  for (i = -1; i < n_breaks - 1; i++)
+    {
+      if (i > start && far == i)
+	{
+	  /* Every path goes through break i. */
+	  segs[n_segs].start = start;
+	  segs[n_segs].end = i;
+	  segs[n_segs].flags = 0;
+	  n_segs++;
+	  start = i;
+	}
+
+      x_prev = x_after (i);
+      if (i >= 0 && i < next && (breaks[i].flags & HNJ_JUST_FLAG_ISSPACE))
+	total_space -= breaks[i].x1 - breaks[i].x0;
+      if (next <= i || params->max_neg_space > 256 ||
+	  params->max_shrink > 256 ||
+	  (tab_rank != NULL && tab_rank[next] > tab_rank[i + 1]))
+	{
+	  next = i + 1;
+	  total_space = 0;
+	}
+      tab_offset = 0;
+      glyph_x = x_prev;
+      while (next < n_breaks &&
+	     !(next > i + 1 &&
+	       (breaks[next - 1].flags & HNJ_JUST_FLAG_ISHARD)) &&
+	     breaks[next].x0 + tab_offset <=
+	     x_prev + set_width + Cost::shrink (total_space, params) +
+	     (expand ? glyph_shrink (breaks[next].x0 - glyph_x - total_space,
+				     params) : 0))
+	{
+	  if (breaks[next].flags & HNJ_JUST_FLAG_ISTAB)
+	    {
+	      next_stop = ((breaks[next].x0 + tab_offset - x_prev) /
+			   tab_width + 1) * tab_width;
+	      tab_offset = x_prev + next_stop - breaks[next].x0;
+	      total_space = 0;
+	      glyph_x = breaks[next].x1;
+	    }
+	  if (breaks[next].flags & HNJ_JUST_FLAG_ISSPACE)
+	    total_space += breaks[next].x1 - breaks[next].x0;
+	  next++;
+	}
+      if (next - 1 > far)
+	far = next - 1;
+      if (far == i)
+	{
+	  /* No line gets past break i, so the line up to the next
+	     break is overfull whatever we do. Force it. */
+	  if (i > start)
+	    {
+	      segs[n_segs].start = start;
+	      segs[n_segs].end = i;
+	      segs[n_segs].flags = 0;
+	      n_segs++;
+	    }
+#ifdef VERBOSE
+	  fprintf (stderr, "overfull line %d - %d\n", i, i + 1);
+#endif
+	  segs[n_segs].start = i;
+	  segs[n_segs].end = i + 1;
+	  segs[n_segs].flags = HNJ_JUST_LINE_OVERFULL;
+	  n_segs++;
+	  start = i + 1;
+	  far = i + 1;
+	}
+    }
+  if (start < n_breaks - 1)
+    {
+      segs[n_segs].start = start;
+      segs[n_segs].end = n_breaks - 1;
+      segs[n_segs].flags = 0;
+      n_segs++;
+    }
+  return n_segs;
+}
+
+/* Justify segments first_seg, first_seg + n_thread, ... Each
+   segment's results go to result + start + 1, where there is always
+   enough room for them. Returns zero, or -1 if out of memory. */
+template <typename Cost, typename Breaks, typename Dist>
+int
+HqJust<Cost, Breaks, Dist>::just_segments (Segment *segs, int n_segs,
+					   int first_seg, int n_thread,
+					   int *result) const
+{
+  Scratch *scratch;
+  QueueEntry *queue;
+  Tabs tabs;
+  int *tab_base;
+  int *n_tab;
+  int max_len;
+  int status;
+  int i;
+
+  max_len = 0;
+  for (i = first_seg; i < n_segs; i += n_thread)
+    if (segs[i].end - segs[i].start > max_len)
+      max_len = segs[i].end - segs[i].start;
+
+  scratch = NULL;
+  queue = NULL;
+  if (max_len > 1)
+    {
+      scratch = (Scratch *) malloc ((max_len + 1) * sizeof (Scratch));
+      queue = (QueueEntry *) malloc ((max_len * 3 + 1) *
+				     sizeof (QueueEntry));
+      if (scratch == NULL || queue == NULL)
+	{
+	  free (scratch);
+	  free (queue);
+	  return -1;
+	}
+    }
+
+  /* The tab offsets are kept apart from the scratch, so that
+     paragraphs without tabs don't pay for them. */
+  tabs.pool = NULL;
+  tabs.pool_size = 0;
+  tab_base = NULL;
+  n_tab = NULL;
+  if (tab_rank != NULL && max_len > 1)
+    {
+      tab_base = (int *) malloc ((max_len + 1) * sizeof (int));
+      n_tab = (int *) malloc ((max_len + 1) * sizeof (int));
+      if (tab_base == NULL || n_tab == NULL)
+	{
+	  free (tab_base);
+	  free (n_tab);
+	  free (queue);
+	  free (scratch);
+	  return -1;
+	}
+    }
+  status = 0;
+  for (i = first_seg; i < n_segs; i += n_thread)
+    {
+      if (segs[i].end - segs[i].start == 1)
+	{
+	  result[segs[i].end] = segs[i].end;
+	  if (lines)
+	    fill_lines (segs[i].start, result + segs[i].end, 1,
+			lines + segs[i].end);
+	  segs[i].n_result = 1;
+	}
+      else
+	{
+	  if (tab_base)
+	    {
+	      /* Indexed from the start of the segment, like the
+		 scratch. */
+	      tabs.base = tab_base - segs[i].start;
+	      tabs.n_tab = n_tab - segs[i].start;
+	    }
+	  segs[i].n_result = just_segment (segs[i].start, segs[i].end,
+					   scratch, queue,
+					   tab_base ? &tabs : NULL,
+					   result + segs[i].start + 1);
+	  if (segs[i].n_result < 0)
+	    {
+	      status = -1;
+	      break;
+	    }
+	}
+    }
+
+  free (tabs.pool);
+  free (tab_base);
+  free (n_tab);
+  free (queue);
+  free (scratch);
+  return status;
+}
+
+#ifdef HNJ_USE_PTHREAD
+/* Look for a break after c that a best path through the segment from
+   start to end goes through, without knowing the best paths up to c.
+
+   Every path has a last break up to c, among those W a line can get
+   past c from. The best paths from each break of W are followed, all
+   at once, a break j at a time. Every path from W to the end has a
+   last break up to j, among those a line can get past j from; once
+   the best paths from all of W to all of those go through a common
+   break after c, the best path from W to the end does, whichever
+   break of W it comes from. Once that holds it holds for every later
+   j too, so it is checked at first once a line, then ever less
+   often, so that the checks cost little next to following the paths.
+
+   Following the paths takes as many steps for each break as there
+   are breaks in W times the breaks of a line, and squared deviations
+   spread a change over many lines, more of them the longer the
+   lines, so the cost goes up with the fourth power of the length of
+   a line. It is kept to HNJ_CUT_WORK steps for each break of the
+   piece, of which the search has to be spared much more for the cut
+   to pay. This also needs the lines a break can end to be
+   contiguous, which doesn't hold with tabs or with spaces or glyphs
+   that may shrink by more than their width. Returns the break, or -1
+   if there is none close enough, or on running out of memory; a
+   missed cut only costs parallelism. */
+template <typename Cost, typename Breaks, typename Dist>
+int
+HqJust<Cost, Breaks, Dist>::find_cut (int start, int end, int c,
+				      int piece) const
+{
+  Scratch *scratch;
+  Scratch *s;
+  Dist *dist;
+  int *pred;
+  Dist *row;
+  int *row_pred;
+  Dist *from;
+  Dist *pen;
+  int *lo;
+  int *count;
+  int *stamp;
+  int lb, last, w0;
+  int n_w, range;
+  long long span;
+  int total_space;
+  int cut;
+  int n_paths;
+  int common;
+  int next_check;
+  int n_e, n_from;
+  int i, j, e, a, b, p;
+  Dist d, d_from, d_row;
+
+  if (tab_rank != NULL || params->max_neg_space > 256 ||
+      params->max_shrink > 256 || c >= end - 1)
+    return -1;
+  lb = c - HNJ_CUT_MAX_WIDTH > start ? c - HNJ_CUT_MAX_WIDTH : start;
+
+  /* Up to c + 1 to find W, then up to last + 1, to see which lines
+     get past last. */
+  scratch = (Scratch *) malloc ((c - lb + 2) * sizeof (Scratch));
+  if (scratch == NULL)
+    return -1;
+  s = scratch - lb;
+  total_space = 0;
+  s[lb].total_space = 0;
+  for (i = lb + 1; i <= c + 1; i++)
+    {
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISSPACE)
+	total_space += breaks[i].x1 - breaks[i].x0;
+      s[i].total_space = total_space;
+    }
+
+  /* W is w0 to c, which is about a line's worth of breaks. */
+  for (w0 = c; w0 > lb; w0--)
+    if (!line_fits (s, NULL, x_after (w0 - 1), w0 - 1, c + 1))
+      break;
+  if (w0 == lb && lb > start)
+    {
+      free (scratch);
+      return -1;
+    }
+  n_w = c - w0 + 1;
+  span = (long long) piece * HNJ_CUT_WORK / ((long long) n_w * n_w);
+  last = span < end - 1 - c ? c + (int) span : end - 1;
+  if (span < HNJ_CUT_MERGE * n_w * n_w || last <= c)
+    {
+      free (scratch);
+      return -1;
+    }
+
+  s = (Scratch *) realloc (scratch, (last - lb + 2) * sizeof (Scratch));
+  if (s == NULL)
+    {
+      free (scratch);
+      return -1;
+    }
+  scratch = s;
+  s = scratch - lb;
+  for (i = c + 2; i <= last + 1; i++)
+    {
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISSPACE)
+	total_space += breaks[i].x1 - breaks[i].x0;
+      s[i].total_space = total_space;
+    }
+
+  range = last - w0 + 1;
+  dist = (Dist *) malloc (n_w * range * sizeof (Dist));
+  pred = (int *) malloc (n_w * range * sizeof (int));
+  pen = (Dist *) malloc (range * sizeof (Dist));
+  lo = (int *) malloc ((range + 1) * sizeof (int));
+  count = (int *) malloc (range * sizeof (int));
+  stamp = (int *) calloc (range, sizeof (int));
+  cut = -1;
+  if (dist == NULL || pred == NULL || pen == NULL || lo == NULL ||
+      count == NULL || stamp == NULL)
+    goto done;
+
+  /* dist and pred of the path from break w0 + e to break j are at
+     (j - w0) * n_w + e. The path starts at minus the penalty of w0 + e,
+     which every line from a break is charged with. lo[j - w0] is the
+     first break a line to break j fits from, or j if there is none.
+     Inside a segment there is always one, but the lines are only
+     those the search would take. */
+  for (i = w0; i <= last; i++)
+    pen[i - w0] = i < 0 ? 0 : Cost::template penalty<Dist> (breaks[i]);
+  for (e = 0; e < n_w; e++)
+    dist[e * n_w + e] = -pen[e];
+  i = w0;
+  for (j = w0 + 1; j <= last + 1; j++)
+    {
+      while (i < j && !line_fits (s, NULL, x_after (i), i, j))
+	i++;
+      lo[j - w0] = i;
+    }
+
+  next_check = c;
+  for (j = w0 + 1; j <= last; j++)
+    {
+      /* The paths from all of W to j at once, a line to j at a time.
+	 A path from w0 + e only gets to breaks from w0 + e on. */
+      row = dist + (j - w0) * n_w;
+      row_pred = pred + (j - w0) * n_w;
+      n_e = j - w0 < n_w ? j - w0 : n_w;
+      for (e = 0; e < n_e; e++)
+	{
+	  row[e] = INF;
+	  row_pred[e] = -1;
+	}
+      for (i = lo[j - w0]; i < j; i++)
+	{
+	  d = dev2 (s, NULL, x_after (i), i, j) + pen[i - w0];
+	  from = dist + (i - w0) * n_w;
+	  n_from = i - w0 + 1 < n_e ? i - w0 + 1 : n_e;
+	  for (e = 0; e < n_from; e++)
+	    {
+	      d_from = from[e];
+	      d_row = row[e] - d;
+	      p = row_pred[e];
+	      row[e] = d_from < d_row ? d_from + d : d_row + d;
+	      row_pred[e] = d_from < d_row ? i : p;
+	    }
+	}
+
+      /* The paths still open are those to lo[j + 1] to j. Mark the
+	 breaks after c on one of them, and count the paths through
+	 each mark, giving up once a path misses all the marks common
+	 to those before it. */
+      if (lo[j + 1 - w0] <= c || (j < next_check && j < last))
+	continue;
+      next_check = j + (j - c) / 4 > j + n_w ? j + (j - c) / 4 : j + n_w;
+      for (e = 0; e < n_w; e++)
+	if (row[e] != INF)
+	  break;
+      if (e == n_w)
+	continue;
+      for (b = j; b > c; b = pred[(b - w0) * n_w + e])
+	{
+	  stamp[b - w0] = j;
+	  count[b - w0] = 0;
+	}
+      n_paths = 0;
+      for (e = 0; e < n_w; e++)
+	for (a = lo[j + 1 - w0]; a <= j; a++)
+	  if (dist[(a - w0) * n_w + e] != INF)
+	    {
+	      common = 0;
+	      for (b = a; b > c; b = pred[(b - w0) * n_w + e])
+		if (stamp[b - w0] == j && count[b - w0] == n_paths)
+		  {
+		    count[b - w0]++;
+		    common = 1;
+		  }
+	      if (!common)
+		goto next;
+	      n_paths++;
+	    }
+      for (e = 0; e < n_w; e++)
+	if (row[e] != INF)
+	  break;
+      for (b = j; b > c; b = pred[(b - w0) * n_w + e])
+	if (count[b - w0] == n_paths)
+	  {
+	    cut = b;
+	    goto done;
+	  }
+    next:
+      ;
+    }
+
+ done:
+  free (scratch);
+  free (dist);
+  free (pred);
+  free (pen);
+  free (lo);
+  free (count);
+  free (stamp);
+  return cut;
+}
+
+/* Look for cuts first_cut, first_cut + n_thread, ... of cuts, in
+   pieces of piece breaks. */
+template <typename Cost, typename Breaks, typename Dist>
+void
+HqJust<Cost, Breaks, Dist>::find_cuts (Cut *cuts, int n_cuts, int first_cut,
+				       int n_thread, int piece) const
+{
+  int i;
+
+  for (i = first_cut; i < n_cuts; i += n_thread)
+    cuts[i].cut = find_cut (cuts[i].start, cuts[i].end, cuts[i].c, piece);
+}
+
+template <typename Cost, typename Breaks, typename Dist>
+void *
+HqJust<Cost, Breaks, Dist>::cut_worker (void *data)
+{
+  CutWorker *w = (CutWorker *) data;
+
+  w->just->find_cuts (w->cuts, w->n_cuts, w->first_cut, w->n_thread,
+		      w->piece);
+  return NULL;
+}
+
+/* Cut the segments into pieces for n_thread threads with find_cut.
+   A cut is looked for a piece's length after the start of a segment,
+   another a piece's length after that, and so on, all at once on the
+   threads, dealt out as the segments are. Each cut is on the best
+   path whatever the others turn out to be, so the pieces go from one
+   cut found to the next. *segs is replaced by the new list, which has
+   room for one segment per break, as before. Returns the number of
+   segments; if out of memory, the segments are left as they are. */
+template <typename Cost, typename Breaks, typename Dist>
+int
+HqJust<Cost, Breaks, Dist>::cut_segments (Segment **segs, int n_segs,
+					  int n_thread) const
+{
+  CutWorker workers[HNJ_MAX_THREADS];
+  Segment *old_segs = *segs;
+  Segment *new_segs;
+  Cut *cuts;
+  int n_cuts;
+  int n_started;
+  int n_new;
+  int piece;
+  int pos, c;
+  int i, k;
+
+  piece = n_breaks / (HNJ_PIECES_PER_THREAD * n_thread);
+  if (piece < HNJ_MIN_PIECE)
+    piece = HNJ_MIN_PIECE;
+  n_cuts = 0;
+  for (i = 0; i < n_segs; i++)
+    if (old_segs[i].flags == 0)
+      for (c = old_segs[i].start + piece; c < old_segs[i].end - piece;
+	   c += piece)
+	n_cuts++;
+  if (n_cuts == 0)
+    return n_segs;
+  cuts = (Cut *) malloc (n_cuts * sizeof (Cut));
+  new_segs = (Segment *) malloc (n_breaks * sizeof (Segment));
+  if (cuts == NULL || new_segs == NULL)
+    {
+      free (cuts);
+      free (new_segs);
+      return n_segs;
+    }
+  k = 0;
+  for (i = 0; i < n_segs; i++)
+    if (old_segs[i].flags == 0)
+      for (c = old_segs[i].start + piece; c < old_segs[i].end - piece;
+	   c += piece)
+	{
+	  cuts[k].start = old_segs[i].start;
+	  cuts[k].end = old_segs[i].end;
+	  cuts[k].c = c;
+	  k++;
+	}
+
+  if (n_thread > n_cuts)
+    n_thread = n_cuts;
+  for (n_started = 1; n_started < n_thread; n_started++)
+    {
+      CutWorker *w = &workers[n_started];
+
+      w->just = this;
+      w->cuts = cuts;
+      w->n_cuts = n_cuts;
+      w->first_cut = n_started;
+      w->n_thread = n_thread;
+      w->piece = piece;
+      if (pthread_create (&w->thread, NULL, cut_worker, w))
+	break;
+    }
+  find_cuts (cuts, n_cuts, 0, n_thread, piece);
+  for (i = n_started; i < n_thread; i++)
+    find_cuts (cuts, n_cuts, i, n_thread, piece);
+  for (i = 1; i < n_started; i++)
+    pthread_join (workers[i].thread, NULL);
+
+  /* A cut may be found past the next one, which is then left out. */
+  n_new = 0;
+  k = 0;
+  for (i = 0; i < n_segs; i++)
+    {
+      pos = old_segs[i].start;
+      for (; k < n_cuts && cuts[k].start == old_segs[i].start; k++)
+	if (cuts[k].cut > pos)
+	  {
+#ifdef VERBOSE
+	    fprintf (stderr, "cut at %d, looking from %d\n", cuts[k].cut,
+		     cuts[k].c);
+#endif
+	    new_segs[n_new].start = pos;
+	    new_segs[n_new].end = cuts[k].cut;
+	    new_segs[n_new].flags = 0;
+	    n_new++;
+	    pos = cuts[k].cut;
+	  }
+      new_segs[n_new].start = pos;
+      new_segs[n_new].end = old_segs[i].end;
+      new_segs[n_new].flags = old_segs[i].flags;
+      n_new++;
+    }
+
+  free (cuts);
+  free (old_segs);
+  *segs = new_segs;
+  return n_new;
+}
+
+template <typename Cost, typename Breaks, typename Dist>
+void *
+HqJust<Cost, Breaks, Dist>::segment_worker (void *data)
+{
+  Worker *w = (Worker *) data;
+
+  w->status = w->just->just_segments (w->segs, w->n_segs, w->first_seg,
+				      w->n_thread, w->result);
+  return NULL;
+}
+
+/* Justify the segments on n_thread threads, including the calling
+   one. Segments are dealt out round robin, which keeps the work
+   balanced for the long runs of similar segments typical of big
+   paragraphs. */
+template <typename Cost, typename Breaks, typename Dist>
+int
+HqJust<Cost, Breaks, Dist>::just_segments_threaded (Segment *segs,
+						    int n_segs,
+						    int n_thread,
+						    int *result) const
+{
+  Worker workers[HNJ_MAX_THREADS];
+  int n_started;
+  int status;
+  int i;
+
+  for (n_started = 1; n_started < n_thread; n_started++)
+    {
+      Worker *w = &workers[n_started];
+
+      w->just = this;
+      w->segs = segs;
+      w->n_segs = n_segs;
+      w->first_seg = n_started;
+      w->n_thread = n_thread;
+      w->result = result;
+      if (pthread_create (&w->thread, NULL, segment_worker, w))
+	break;
+    }
+
+  /* If not all threads could be started, the calling thread picks up
+     the segments of the missing ones. */
+  status = just_segments (segs, n_segs, 0, n_thread, result);
+  for (i = n_started; i < n_thread; i++)
+    if (just_segments (segs, n_segs, i, n_thread, result))
+      status = -1;
+
+  for (i = 1; i < n_started; i++)
+    {
+      pthread_join (workers[i].thread, NULL);
+      if (workers[i].status)
+	status = -1;
+    }
+  return status;
+}
+
+template <typename Cost, typename Breaks, typename Dist>
+int
+HqJust<Cost, Breaks, Dist>::get_n_thread () const
+{
+  long n_cpu;
+
+  if (max_threads == 1 ||
+      (max_threads == 0 && n_breaks < HNJ_PARALLEL_MIN_BREAKS))
+    return 1;
+  if (max_threads > 0)
+    n_cpu = max_threads;
+  else
+    n_cpu = sysconf (_SC_NPROCESSORS_ONLN);
+  if (n_cpu > HNJ_MAX_THREADS)
+    n_cpu = HNJ_MAX_THREADS;
+  if (n_cpu > n_breaks / HNJ_MIN_PIECE)
+    n_cpu = n_breaks / HNJ_MIN_PIECE;
+  return n_cpu < 1 ? 1 : n_cpu;
+}
+#endif
+
+/* See hnj_hq_just_flags in hqjust.h. */
+template <typename Cost, typename Breaks, typename Dist>
+int
+HqJust<Cost, Breaks, Dist>::run (int *result, int *result_flags)
+{
+  Segment *segs;
+  int n_segs;
+#ifdef HNJ_USE_PTHREAD
+  int n_thread;
+#endif
+  int status;
+  int n_result;
+  int i, j;
+
+  if (n_breaks <= 0)
+    return 0;
+
+  for (i = 0; i < n_breaks; i++)
+    if (breaks[i].flags & HNJ_JUST_FLAG_ISTAB)
+      break;
+  if (i < n_breaks)
+    {
+      tab_rank = (int *) malloc ((n_breaks + 1) * sizeof (int));
+      tab_idx = (int *) malloc (n_breaks * sizeof (int));
+      if (tab_rank == NULL || tab_idx == NULL)
+	{
+	  free (tab_rank);
+	  free (tab_idx);
+	  tab_rank = tab_idx = NULL;
+	  return -1;
+	}
+      j = 0;
+      for (i = 0; i < n_breaks; i++)
+	{
+	  tab_rank[i] = j;
+	  if (breaks[i].flags & HNJ_JUST_FLAG_ISTAB)
+	    tab_idx[j++] = i;
+	}
+      tab_rank[n_breaks] = j;
+    }
+
+  /* There's at most one segment per break. */
+  segs = (Segment *) malloc (n_breaks * sizeof (Segment));
+  if (segs == NULL)
+    {
+      free (tab_rank);
+      free (tab_idx);
+      tab_rank = tab_idx = NULL;
+      return -1;
+    }
+  n_segs = find_segments (segs);
+
+#ifdef VERBOSE
+  fprintf (stderr, "%d segments\n", n_segs);
+#endif
+
+#ifdef HNJ_USE_PTHREAD
+  /* The budget is spent a segment at a time, in order. */
+  n_thread = budget == NULL ? get_n_thread () : 1;
+  if (n_thread > 1)
+    n_segs = cut_segments (&segs, n_segs, n_thread);
+  if (n_thread > n_segs)
+    n_thread = n_segs;
+  if (n_thread > 1)
+    status = just_segments_threaded (segs, n_segs, n_thread, result);
+  else
+#endif
+    status = just_segments (segs, n_segs, 0, 1, result);
+
+  /* Stitch the segments' results together. They only ever move
+     towards the front, so this can be done in place. */
+  n_result = 0;
+  if (status == 0)
+    for (i = 0; i < n_segs; i++)
+      for (j = 0; j < segs[i].n_result; j++)
+	{
+	  result[n_result] = result[segs[i].start + 1 + j];
+	  if (result_flags)
+	    result_flags[n_result] = segs[i].flags;
+	  if (lines)
+	    {
+	      lines[n_result] = lines[segs[i].start + 1 + j];
+	      lines[n_result].flags |= segs[i].flags;
+	    }
+	  n_result++;
+	}
+  else
+    n_result = -1;
+
+  free (segs);
+  free (tab_rank);
+  free (tab_idx);
+  tab_rank = tab_idx = NULL;
+
+  return n_result;
+}
+
+template <typename Cost, typename Dist, typename Breaks>
+inline int
+hq_just (Breaks breaks, int n_breaks, const HnjParams *params,
+	 int *result, int *result_flags = NULL, Budget *budget = NULL)
+{
+  HqJust<Cost, Breaks, Dist> just (breaks, n_breaks, params);
+
+  just.set_budget (budget);
+  return just.run (result, result_flags);
+}
+
+/* A simple, high speed justification algorithm. Uses the greedy
+   approach. This is hs_just without its adjustment of the penalties,
+   which makes no difference as long as the x0 of the breaks never go
+   backwards, and only reads the breaks. */
+template <typename Cost, typename Dist, typename Breaks>
+int
+hs_just_unadjusted (Breaks breaks, int n_breaks, const HnjParams *params,
+		    int *result)
+{
+  int set_width = params->set_width;
+  int tab_width = params->tab_width;
+  int break_in_idx;
+  int result_idx;
+  int x;
+  int total_space; /* total space seen so far */
+  Dist best_penalty;
+  int best_idx;
+  int space_err;
+  Dist penalty;
+  int tab_offset;
+  int glyph_x;
+  int glyphs;
+
+  if (tab_width == 0)
+    tab_width = 1;
+
+  break_in_idx = 0;
+  result_idx = 0;
+  x = 0;
+  while (break_in_idx != n_breaks)
+    {
+      total_space = 0;
+      tab_offset = 0;
+      glyph_x = x;
+
+      /* Calculate penalty for first possible break. */
+      space_err = breaks[break_in_idx].x0 - (x + set_width);
+      best_penalty = expanded_line<Cost, Dist> (space_err,
+						breaks[break_in_idx].x0 - x,
+						0, breaks[break_in_idx],
+						params) +
+	Cost::template penalty<Dist> (breaks[break_in_idx]);
+      best_idx = break_in_idx;
+
+      /* Check for a tab. */
+      if (breaks[break_in_idx].flags & HNJ_JUST_FLAG_ISTAB)
+	{
+	  int next_stop = ((breaks[break_in_idx].x0 + tab_offset - x)
+			   / tab_width + 1) * tab_width;
+	  tab_offset = x + next_stop - breaks[break_in_idx].x0;
+	  glyph_x = breaks[break_in_idx].x1;
+	}
+
+      /* Now, keep trying to find a better break until either alll
+	 breaks are exhausted, or the maximum negative space
+	 constraint is violated, or the distance penalty is larger
+	 than the best total penalty so far, or a hard break ends the
+	 line. */
+
+      if (breaks[break_in_idx].flags & HNJ_JUST_FLAG_ISSPACE)
+	total_space += breaks[break_in_idx].x1 - breaks[break_in_idx].x0;
+      break_in_idx++;
+
+      while (break_in_idx < n_breaks &&
+	     !(breaks[break_in_idx - 1].flags & HNJ_JUST_FLAG_ISHARD) &&
+	     breaks[break_in_idx].x0 + tab_offset <=
+	     x + set_width + Cost::shrink (total_space, params) +
+	     glyph_shrink (breaks[break_in_idx].x0 - glyph_x - total_space,
+			   params))
+	{
+	  /* Calculate penalty of this break. */
+	  space_err = breaks[break_in_idx].x0 + tab_offset - (x + set_width);
+	  glyphs = breaks[break_in_idx].x0 - glyph_x - total_space;
+	  penalty = expanded_line<Cost, Dist> (space_err, glyphs,
+					       Cost::shrink (total_space,
+							     params),
+					       breaks[break_in_idx], params);
+
+	  /* Check for a tab. */
+	  if (breaks[break_in_idx].flags & HNJ_JUST_FLAG_ISTAB)
+	    {
+	      int next_stop = ((breaks[break_in_idx].x0 + tab_offset - x)
+			       / tab_width + 1) * tab_width;
+	      tab_offset = x + next_stop - breaks[break_in_idx].x0;
+	      total_space = 0;
+	      glyph_x = breaks[break_in_idx].x1;
+	    }
+
+	  /* Continue penalty calculation. */
+	  if (penalty > best_penalty)
+	    break;
+	  penalty += Cost::template penalty<Dist> (breaks[break_in_idx]);
+	  if (penalty <= best_penalty)
+	    {
+	      best_penalty = penalty;
+	      best_idx = break_in_idx;
+	    }
+
+	  if (breaks[break_in_idx].flags & HNJ_JUST_FLAG_ISSPACE)
+	    total_space += breaks[break_in_idx].x1 - breaks[break_in_idx].x0;
+	  break_in_idx++;
+	}
+
+      result[result_idx++] = best_idx;
+      x = breaks[best_idx].x1;
+      break_in_idx = best_idx + 1;
+    }
+
+  return result_idx;
+}
+
+/* A simple, high speed justification algorithm. Uses the greedy
+   approach. The breaks must be writable; see hnj_hs_just in
+   hsjust.h. */
+template <typename Cost, typename Dist, typename Breaks>
+int
+hs_just (Breaks breaks, int n_breaks, const HnjParams *params, int *result)
+{
+  int break_in_idx;
+
+  for ( break_in_idx = 1; break_in_idx < n_breaks; break_in_idx ++ )
+    {
+      if ( breaks[break_in_idx].x0 < breaks[break_in_idx - 1].x0 )
+	{
+	  int j;
+	  for ( j = break_in_idx - 1; j >= 0; j-- )
+	    {
+	      if ( breaks[j].x0 <= breaks[break_in_idx].x0 )
+		break;
+	      if ( breaks[j].penalty < INT_MAX / 2 )
+		breaks[j].penalty += INT_MAX / 2;
+	    }
+	}
+    }
+
+  return hs_just_unadjusted<Cost, Dist> (breaks, n_breaks, params, result);
+}
+
+/* Fill in lines with the layout of the n_result lines of a result,
+   in one pass over the breaks. result_flags may be NULL. */
+template <typename Cost, typename Dist, typename Breaks>
+void
+line_records (Breaks breaks, const HnjParams *params, const int *result,
+	      const int *result_flags, int n_result, HnjLine *lines)
+{
+  int k;
+
+  for (k = 0; k < n_result; k++)
+    line_record<Cost, Dist> (breaks, params, k ? result[k - 1] : -1,
+			     result[k], result_flags ? result_flags[k] : 0,
+			     k == n_result - 1, &lines[k]);
+}
+
+
+/* Whether break i, which isn't a space, tab or hard break, can be
+   dropped in favour of a neighbour j identical but for a lower
+   penalty (or the same penalty and an earlier place). Lines ending
+   at j are the same as lines ending at i, and likewise for lines
+   starting after them. */
+template <typename Cost, typename Breaks>
+bool
+break_duplicated (Breaks breaks, int i, int j)
+{
+  return breaks[j].x0 == breaks[i].x0 && breaks[j].x1 == breaks[i].x1 &&
+    breaks[j].flags == breaks[i].flags &&
+    (Cost::template penalty<long long> (breaks[j]) <
+     Cost::template penalty<long long> (breaks[i]) ||
+     (Cost::template penalty<long long> (breaks[j]) ==
+      Cost::template penalty<long long> (breaks[i]) && j < i));
+}
+
+/* The cost under Cost of a line from a break ending at x to break q,
+   with total_space worth of spaces in it and no tabs, or -1 if it
+   doesn't fit. */
+template <typename Cost, typename Breaks>
+static inline long long
+plain_line_cost (Breaks breaks, const HnjParams *params, int x, int q,
+		 int total_space)
+{
+  int dev = breaks[q].x0 - (x + params->set_width);
+  int glyphs = breaks[q].x0 - x - total_space;
+  int space_shrink = Cost::shrink (total_space, params);
+
+  if (dev > space_shrink + glyph_shrink (glyphs, params))
+    return -1;
+  return expanded_line<Cost, long long> (dev, glyphs, space_shrink,
+					 breaks[q], params);
+}
+
+/* Whether the line from a break ending at x to break q, with
+   total_space worth of spaces in it and no tabs, fits. */
+template <typename Cost, typename Breaks>
+static inline bool
+plain_line_fits (Breaks breaks, const HnjParams *params, int x, int q,
+		 int total_space)
+{
+  return breaks[q].x0 - (x + params->set_width) <=
+    Cost::shrink (total_space, params) +
+    glyph_shrink (breaks[q].x0 - x - total_space, params);
+}
+
+/* Whether the line from a break ending at x to break q is short of
+   set_width and, without font expansion, costs more than bound. Lines
+   only get dearer the looser they are. */
+template <typename Cost, typename Breaks>
+static inline bool
+plain_line_loose (Breaks breaks, const HnjParams *params, int x, int q,
+		  long long bound)
+{
+  int dev = breaks[q].x0 - (x + params->set_width);
+
+  return dev < 0 && Cost::template line<long long> (dev, breaks[q]) > bound;
+}
+
+/* Whether hyphen h, inside a word of a run of breaks without tabs,
+   can be left out in favour of space j, the end of its word, without
+   font expansion: whether for every line from a break p to h and
+   every line from h to a break q that may be on a least cost path,
+   going through j instead is no worse. The lines to h fit from p_lo
+   on, the lines from h that may be on a least cost path end at q_lo
+   or after it, the first of them fits, and end is the end of the
+   run. space[i + 1] is the width of the spaces up to break i.
+
+   Going through j instead of h costs cost (p, j) - cost (p, h) +
+   cost (j, q) - cost (h, q) + penalty (j) - penalty (h). A line costs
+   the square of its deviation, which j moves by the same amount
+   whatever p or q is, so the extra cost of the line from p grows with
+   its deviation and is at its worst on the tightest line, from p_lo,
+   and that of the line to q shrinks with it and is at its worst on
+   the loosest line, to q_lo, or the last, which costs nothing. A line
+   that fits still fits when it gets shorter, so if the line from p_lo
+   to j fits, so do all the others; the rest of the word after h
+   mustn't be narrower than nothing for that. */
+template <typename Cost, typename Breaks>
+bool
+hyphen_dominated (Breaks breaks, const HnjParams *params, const int *space,
+		  int p_lo, int h, int j, int q_lo, int end)
+{
+  int x = p_lo == -1 ? 0 : breaks[p_lo].x1;
+  long long worst_p, worst_q;
+  long long c_j;
+
+  c_j = plain_line_cost<Cost, Breaks> (breaks, params, x, j,
+				       space[j] - space[p_lo + 1]);
+  if (c_j < 0)
+    return false;
+  worst_p = c_j - plain_line_cost<Cost, Breaks> (breaks, params, x, h,
+						 space[h] - space[p_lo + 1]);
+  worst_q = plain_line_cost<Cost, Breaks> (breaks, params, breaks[j].x1,
+					   q_lo, space[q_lo] - space[j + 1]) -
+    plain_line_cost<Cost, Breaks> (breaks, params, breaks[h].x1, q_lo,
+				   space[q_lo] - space[h + 1]);
+  if (worst_q < 0 && !Cost::justified (breaks[end]) &&
+      plain_line_fits<Cost, Breaks> (breaks, params, breaks[h].x1, end,
+				     space[end] - space[h + 1]))
+    worst_q = 0;
+  return worst_p + worst_q + Cost::template penalty<long long> (breaks[j]) -
+    Cost::template penalty<long long> (breaks[h]) <= 0;
+}
+
+/* Drop the breaks that can't be on a least cost path of hq_just with
+   the same Cost, copying the rest to pruned and their indices to map.
+   Returns the number of breaks kept.
+
+   Every path goes through the hard breaks, so the paragraph is taken
+   a run of breaks up to a hard break (or the end) at a time. A break
+   in a run whose penalty alone is more than the cost of the greedy
+   path through the run can't be on the best path, since no line
+   costs less than nothing; nor can one of several identical breaks
+   but the cheapest.
+
+   Nor is a hyphen needed where breaking at the space after its word
+   instead is never worse (see hyphen_dominated): take a best path
+   through the fewest dropped hyphens; if it went through one, h
+   between p and q, going through that space instead would give a
+   path as good through fewer, as the space isn't on the path already
+   and is kept. No line on a best path costs more than the greedy
+   path, which bounds the lines to look at. This needs the lines a
+   break can end to be contiguous, as in find_cut, every break of the
+   run but its end to be justified, no tabs and no font expansion.
+
+   Spaces and tabs are always kept, as they change the lines that
+   cross them. Dropping breaks must not let a line that doesn't fit
+   become the forced, overfull line between two breaks that have
+   become neighbours, so if the breaks either side of the dropped ones
+   are too far apart for a line, those are kept after all. This leaves
+   the feasible lines between the kept breaks as they were, and so the
+   cost of the best path.
+
+   If any penalty is negative, nothing is dropped. */
+template <typename Cost, typename Breaks>
+int
+prune_breaks (Breaks breaks, int n_breaks, const HnjParams *params,
+	      HnjBreak *pruned, int *map)
+{
+  const int word_end = HNJ_JUST_FLAG_ISSPACE | HNJ_JUST_FLAG_ISTAB |
+    HNJ_JUST_FLAG_ISHARD;
+  bool negative = false;
+  bool hyphens;
+  long long upper;
+  int *space;
+  int next_space;
+  int p_lo, q_lo;
+  int n_pruned = 0;
+  int start, end;
+  int kept;
+  int i, j;
+
+  for (i = 0; i < n_breaks; i++)
+    if (Cost::template penalty<long long> (breaks[i]) < 0)
+      negative = true;
+
+  /* The hyphens are only looked at if there is memory for the widths
+     of the spaces; they can always be kept. Spaces that shrink by no
+     more than their width leave a line that fits fitting when it gets
+     shorter. */
+  space = NULL;
+  if (!negative && !has_expansion (params) && params->max_neg_space <= 256)
+    {
+      space = (int *) malloc ((n_breaks + 1) * sizeof (int));
+      if (space)
+	{
+	  space[0] = 0;
+	  for (i = 0; i < n_breaks; i++)
+	    space[i + 1] = space[i] +
+	      ((breaks[i].flags & HNJ_JUST_FLAG_ISSPACE) ?
+	       breaks[i].x1 - breaks[i].x0 : 0);
+	}
+    }
+
+  for (start = -1; start < n_breaks - 1; start = end)
+    {
+      hyphens = space != NULL;
+      for (end = start + 1; end < n_breaks - 1; end++)
+	{
+	  if (breaks[end].flags & HNJ_JUST_FLAG_ISHARD)
+	    break;
+	  if ((breaks[end].flags & HNJ_JUST_FLAG_ISTAB) ||
+	      !Cost::justified (breaks[end]))
+	    hyphens = false;
+	}
+      upper = negative ? LLONG_MAX :
+	greedy_path<Cost, Breaks> (breaks, params, start, end, NULL, NULL);
+      if (upper == LLONG_MAX)
+	hyphens = false;
+#ifdef VERBOSE
+      fprintf (stderr, "prune %d - %d: upper bound %lld\n", start, end,
+	       upper);
+#endif
+      kept = start;
+      p_lo = start;
+      q_lo = start;
+      next_space = start;
+      for (i = start + 1; i <= end; i++)
+	{
+	  if (i < end && !negative && !(breaks[i].flags & word_end))
+	    {
+	      if (Cost::template penalty<long long> (breaks[i]) > upper ||
+		  (i > start + 1 &&
+		   break_duplicated<Cost, Breaks> (breaks, i, i - 1)) ||
+		  (i + 1 < end &&
+		   break_duplicated<Cost, Breaks> (breaks, i, i + 1)))
+		continue;
+	      if (hyphens && (breaks[i].flags & HNJ_JUST_FLAG_ISHYPHEN))
+		{
+		  /* A line next to i that doesn't fit may be forced,
+		     so i is kept then. */
+		  if (next_space <= i)
+		    for (next_space = i + 1;
+			 next_space < end &&
+			 !(breaks[next_space].flags & word_end);
+			 next_space++)
+		      ;
+		  while (p_lo < i &&
+			 !plain_line_fits<Cost, Breaks>
+			 (breaks, params, p_lo == -1 ? 0 : breaks[p_lo].x1, i,
+			  space[i] - space[p_lo + 1]))
+		    p_lo++;
+		  if (q_lo <= i)
+		    q_lo = i + 1;
+		  while (q_lo < end &&
+			 plain_line_loose<Cost, Breaks>
+			 (breaks, params, breaks[i].x1, q_lo, upper))
+		    q_lo++;
+		  if (next_space < end &&
+		      (breaks[next_space].flags & HNJ_JUST_FLAG_ISSPACE) &&
+		      breaks[next_space].x0 >= breaks[i].x1 &&
+		      p_lo < i && q_lo > next_space &&
+		      plain_line_fits<Cost, Breaks>
+		      (breaks, params, breaks[i].x1, i + 1, 0) &&
+		      plain_line_fits<Cost, Breaks>
+		      (breaks, params, breaks[i].x1, q_lo,
+		       space[q_lo] - space[i + 1]) &&
+		      hyphen_dominated<Cost, Breaks>
+		      (breaks, params, space, p_lo, i, next_space, q_lo, end))
+		    continue;
+		}
+	    }
+	  if (i > kept + 1 &&
+	      breaks[i].x0 - (kept == -1 ? 0 : breaks[kept].x1) >
+	      params->set_width + Cost::shrink (0, params) +
+	      glyph_shrink (breaks[i].x0 - (kept == -1 ? 0 : breaks[kept].x1),
+			    params))
+	    for (j = kept + 1; j < i; j++)
+	      {
+		pruned[n_pruned] = breaks[j];
+		map[n_pruned++] = j;
+	      }
+	  pruned[n_pruned] = breaks[i];
+	  map[n_pruned++] = i;
+	  kept = i;
+	}
+    }
+  free (space);
+  return n_pruned;
+}
+
+} /* namespace hnj */
+
+#endif /* __HNJ_JUST_HH__ */
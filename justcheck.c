@@ -0,0 +1,674 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Differential check of the justifiers against a reference.
+
+   Usage: justcheck [-n paragraphs] [-w max-words] [-s seed] [-y] [-v]
+
+   Random paragraphs are justified by every engine and by a plain
+   O(n^2) dynamic programming justifier over the same cost model as
+   hnj_hq_just. The total penalty of each result is computed
+   independently of the engines. hnj_hq_just must match the reference
+   exactly; the greedy hnj_hs_just is only reported. Exits nonzero on
+   any mismatch. The breaks and search steps hnj_prune_breaks saves
+   are reported too; -y hyphenates every word that is long enough, and
+   leaves out tabs, as in hyphen-dense text. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "autojust.h"
+#include "hqjust.h"
+#include "hsjust.h"
+#include "breakpack.h"
+
+/* Cost of an overfull line. Paths are compared on the number of
+   overfull lines first, then on penalty. */
+#define OVERFULL_COST (1LL << 40)
+
+typedef struct _Engine Engine;
+
+struct _Engine {
+  const char *name;
+  int exact; /* must match the reference */
+  int (*just) (const HnjBreak *breaks, int n_breaks,
+	       const HnjParams *params, int *result);
+  double time;
+  long long cost;
+  int n_mismatches;
+};
+
+#define ENGINE(name, exact, just) { name, exact, just, 0, 0, 0 }
+
+static double
+get_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The end of a line from break p to break q, once each tab on it
+   has moved the rest of the line to the next multiple of tab_width
+   from the start of the line. *total_space is set to the space after
+   the last tab, or in the whole line if there is none, and *glyphs
+   to the width of the rest of the line after the last tab. */
+static int
+line_end (const HnjBreak *breaks, int p, int q, const HnjParams *params,
+	  int *total_space, int *glyphs)
+{
+  int x = p == -1 ? 0 : breaks[p].x1;
+  int tab_width = params->tab_width ? params->tab_width : 1;
+  int offset = 0;
+  int glyph_x = x;
+  int i;
+
+  *total_space = 0;
+  for (i = p + 1; i < q; i++)
+    {
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISTAB)
+	{
+	  offset = x + ((breaks[i].x0 + offset - x) / tab_width + 1) *
+	    tab_width - breaks[i].x0;
+	  *total_space = 0;
+	  glyph_x = breaks[i].x1;
+	}
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISSPACE)
+	*total_space += breaks[i].x1 - breaks[i].x0;
+    }
+  *glyphs = breaks[q].x0 - glyph_x - *total_space;
+  return breaks[q].x0 + offset;
+}
+
+/* How much the spaces and the glyphs of a line may shrink. */
+static int
+space_shrink (int total_space, const HnjParams *params)
+{
+  return (int) (((long long) total_space * params->max_neg_space + 0x80) >>
+		8);
+}
+
+static int
+glyph_shrink (int glyphs, const HnjParams *params)
+{
+  return glyphs <= 0 ? 0 : (glyphs * params->max_shrink + 0x80) >> 8;
+}
+
+/* The part of the deviation dev of a line its glyphs take: the even
+   share nearest zero, within max_expand or max_shrink, or whatever
+   the spaces can't shrink by. */
+static int
+glyph_part (int dev, int glyphs, int total_space, const HnjParams *params)
+{
+  int g;
+
+  if (dev < 0)
+    {
+      g = dev / 2;
+      if (glyphs <= 0)
+	return 0;
+      if (-g > (glyphs * params->max_expand + 0x80) >> 8)
+	g = -((glyphs * params->max_expand + 0x80) >> 8);
+      return g;
+    }
+  g = dev / 2;
+  if (dev - g > space_shrink (total_space, params))
+    g = dev - space_shrink (total_space, params);
+  if (g > glyph_shrink (glyphs, params))
+    g = glyph_shrink (glyphs, params);
+  return g;
+}
+
+/* The cost model of hnj_hq_just. A line from break p (-1 for the
+   start of the paragraph) to break q costs the square of its
+   deviation from set_width if q is a space, hyphen or tab, plus the
+   penalty of p; with font expansion, the squares of the parts of the
+   deviation the spaces and the glyphs take. It is feasible if it
+   takes away no more than max_neg_space / 256 of the space after its
+   last tab and max_shrink / 256 of the glyphs, no tab on it goes past
+   the end of the line, and it doesn't cross a hard break. */
+static int
+line_feasible (const HnjBreak *breaks, int p, int q,
+	       const HnjParams *params)
+{
+  int x = p == -1 ? 0 : breaks[p].x1;
+  int total_space;
+  int glyphs;
+  int i;
+
+  for (i = p + 1; i <= q; i++)
+    {
+      if (i < q && (breaks[i].flags & HNJ_JUST_FLAG_ISHARD))
+	return 0;
+      if ((i == q || (breaks[i].flags & HNJ_JUST_FLAG_ISTAB)) &&
+	  line_end (breaks, p, i, params, &total_space, &glyphs) >
+	  x + params->set_width + space_shrink (total_space, params) +
+	  glyph_shrink (glyphs, params))
+	return 0;
+    }
+  return 1;
+}
+
+static long long
+line_cost (const HnjBreak *breaks, int p, int q, const HnjParams *params)
+{
+  int x = p == -1 ? 0 : breaks[p].x1;
+  long long cost = p == -1 ? 0 : breaks[p].penalty;
+  long long dev;
+  long long g;
+  int total_space;
+  int glyphs;
+
+  if (breaks[q].flags & (HNJ_JUST_FLAG_ISSPACE | HNJ_JUST_FLAG_ISHYPHEN |
+			 HNJ_JUST_FLAG_ISTAB))
+    {
+      dev = line_end (breaks, p, q, params, &total_space, &glyphs) -
+	(x + params->set_width);
+      g = glyph_part (dev, glyphs, total_space, params);
+      cost += (dev - g) * (dev - g) + g * g;
+    }
+  if (!line_feasible (breaks, p, q, params))
+    cost += OVERFULL_COST;
+  return cost;
+}
+
+/* Total cost of a result, or -1 if it isn't a valid breaking of the
+   paragraph. Only lines of a single break may be infeasible. */
+static long long
+path_cost (const HnjBreak *breaks, int n_breaks, const HnjParams *params,
+	   const int *result, int n_result)
+{
+  long long cost = 0;
+  int p = -1;
+  int i;
+
+  if (n_result < 1 || result[n_result - 1] != n_breaks - 1)
+    return -1;
+  for (i = 0; i < n_result; i++)
+    {
+      if (result[i] <= p || result[i] >= n_breaks)
+	return -1;
+      if (result[i] > p + 1 && !line_feasible (breaks, p, result[i], params))
+	return -1;
+      cost += line_cost (breaks, p, result[i], params);
+      p = result[i];
+    }
+  return cost;
+}
+
+/* The reference: the textbook dynamic program over all pairs of
+   breaks. A line of a single break is always allowed, at
+   OVERFULL_COST if it is infeasible. */
+static int
+ref_just (const HnjBreak *breaks, int n_breaks, const HnjParams *params,
+	  int *result)
+{
+  long long *dist;
+  int *pred;
+  long long d;
+  int p, q;
+  int n_result;
+
+  dist = malloc ((n_breaks + 1) * sizeof (long long)) ;
+  pred = malloc ((n_breaks + 1) * sizeof (int));
+  dist++;
+  pred++;
+  dist[-1] = 0;
+  for (q = 0; q < n_breaks; q++)
+    {
+      dist[q] = -1;
+      for (p = q - 1; p >= -1; p--)
+	{
+	  if (dist[p] < 0 || (p + 1 < q && !line_feasible (breaks, p, q,
+							    params)))
+	    continue;
+	  d = dist[p] + line_cost (breaks, p, q, params);
+	  if (dist[q] < 0 || d < dist[q])
+	    {
+	      dist[q] = d;
+	      pred[q] = p;
+	    }
+	}
+    }
+
+  n_result = 0;
+  for (q = n_breaks - 1; q != -1; q = pred[q])
+    n_result++;
+  p = n_result;
+  for (q = n_breaks - 1; q != -1; q = pred[q])
+    result[--p] = q;
+
+  free (dist - 1);
+  free (pred - 1);
+  return n_result;
+}
+
+static int
+hq_packed_just (const HnjBreak *breaks, int n_breaks,
+		const HnjParams *params, int *result)
+{
+  HnjPackedBreaks *packed;
+  int n_result;
+
+  packed = hnj_packed_breaks_new (breaks, n_breaks);
+  n_result = hnj_hq_just_packed (packed, params, result, NULL);
+  hnj_packed_breaks_free (packed);
+  return n_result;
+}
+
+static int
+hq_pruned_just (const HnjBreak *breaks, int n_breaks,
+		const HnjParams *params, int *result)
+{
+  return hnj_hq_just_pruned (breaks, n_breaks, params, result, NULL);
+}
+
+/* On four threads, which paragraphs only get from a couple of
+   thousand breaks up; see gen_long_paragraph for those. */
+static int
+hq_threads_just (const HnjBreak *breaks, int n_breaks,
+		 const HnjParams *params, int *result)
+{
+  return hnj_hq_just_threads (breaks, n_breaks, params, 4, result, NULL);
+}
+
+/* The line records laid out while reading out the best path must be
+   those hnj_hq_line_records works out from the result afterwards;
+   if they aren't, the result is thrown away. */
+static int
+hq_lines_just (const HnjBreak *breaks, int n_breaks,
+	       const HnjParams *params, int *result)
+{
+  HnjLine *lines;
+  HnjLine *check;
+  int *flags_result;
+  int *result_flags;
+  int n_result;
+
+  lines = malloc (n_breaks * sizeof (HnjLine));
+  check = malloc (n_breaks * sizeof (HnjLine));
+  flags_result = malloc (n_breaks * sizeof (int));
+  result_flags = malloc (n_breaks * sizeof (int));
+  n_result = hnj_hq_just_lines (breaks, n_breaks, params, result, lines);
+  if (n_result > 0)
+    {
+      hnj_hq_just_flags (breaks, n_breaks, params, flags_result,
+			 result_flags);
+      hnj_hq_line_records (breaks, params, result, result_flags, n_result,
+			   check);
+      if (memcmp (lines, check, n_result * sizeof (HnjLine)))
+	n_result = -1;
+    }
+  free (lines);
+  free (check);
+  free (flags_result);
+  free (result_flags);
+  return n_result;
+}
+
+/* A budget of a step per break, which is usually not enough. */
+static int
+hq_anytime_just (const HnjBreak *breaks, int n_breaks,
+		 const HnjParams *params, int *result)
+{
+  return hnj_hq_just_anytime (breaks, n_breaks, params, n_breaks, 0, result,
+			      NULL, NULL);
+}
+
+/* With the built-in profile, whatever LIBJUSTIFY_PROFILE says. It
+   only sets paragraphs with hnj_hs_just where that finds the best
+   result. */
+static int
+auto_just (const HnjBreak *breaks, int n_breaks, const HnjParams *params,
+	   int *result)
+{
+  HnjJustProfile profile;
+
+  hnj_just_profile_init (&profile);
+  return hnj_just_auto (breaks, n_breaks, params, &profile, result, NULL);
+}
+
+static int
+hs_just (const HnjBreak *breaks, int n_breaks, const HnjParams *params,
+	 int *result)
+{
+  return hnj_hs_just ((HnjBreak *) breaks, n_breaks, params, result);
+}
+
+static int
+hs_packed_just (const HnjBreak *breaks, int n_breaks,
+		const HnjParams *params, int *result)
+{
+  HnjPackedBreaks *packed;
+  int n_result;
+
+  packed = hnj_packed_breaks_new (breaks, n_breaks);
+  n_result = hnj_hs_just_packed (packed, params, result);
+  hnj_packed_breaks_free (packed);
+  return n_result;
+}
+
+static Engine engines[] = {
+  ENGINE ("reference", 1, ref_just),
+  ENGINE ("hq", 1, hnj_hq_just),
+  ENGINE ("hq-packed", 1, hq_packed_just),
+  ENGINE ("hq-pruned", 1, hq_pruned_just),
+  ENGINE ("hq-threads", 1, hq_threads_just),
+  ENGINE ("hq-lines", 1, hq_lines_just),
+  ENGINE ("hq-anytime", 0, hq_anytime_just),
+  ENGINE ("auto", 1, auto_just),
+  ENGINE ("hs", 0, hs_just),
+  ENGINE ("hs-packed", 0, hs_packed_just),
+};
+
+#define N_ENGINES (sizeof (engines) / sizeof (engines[0]))
+
+/* Generate a random paragraph of up to max_words words, with random
+   hyphenation points, the occasional tab or hard break and the
+   occasional word that doesn't fit on a line. Widths are kept small
+   enough for the total penalty to fit in an int. If dense, every word
+   gets hyphenation points if it can, and there are no tabs. */
+static int
+gen_paragraph (HnjBreak *breaks, int max_words, int dense,
+	       HnjParams *params)
+{
+  int n_words = 1 + rand () % max_words;
+  int spacewidth = 10 + rand () % 10;
+  int hyphwidth = 5 + rand () % 10;
+  int n_breaks = 0;
+  int x = 0;
+  int i, j;
+  int n_hyph;
+  int w;
+
+  params->set_width = 300 + rand () % 1200;
+  params->max_neg_space = rand () % 200;
+  params->tab_width = rand () % 2 ? 0 : 20 + rand () % 400;
+  if (dense)
+    params->tab_width = 0;
+  params->max_expand = rand () % 2 ? 0 : rand () % 16;
+  params->max_shrink = rand () % 2 ? 0 : rand () % 16;
+
+  for (i = 0; i < n_words; i++)
+    {
+      w = 10 + rand () % 150;
+      if (rand () % 200 == 0)
+	w += params->set_width;
+      /* Keep the x0 in order, as just.h requires: the fragments after
+	 a hyphen are wider than the hyphen. */
+      n_hyph = dense ? 1 + rand () % 3 : rand () % 4 ? 0 : rand () % 4;
+      if (n_hyph && w / (n_hyph + 1) <= hyphwidth)
+	n_hyph = 0;
+      for (j = 0; j < n_hyph; j++)
+	{
+	  x += w / (n_hyph + 1);
+	  breaks[n_breaks].x0 = x + hyphwidth;
+	  breaks[n_breaks].x1 = x;
+	  breaks[n_breaks].penalty = 5000 + rand () % 10000;
+	  breaks[n_breaks].flags = HNJ_JUST_FLAG_ISHYPHEN;
+	  n_breaks++;
+	}
+      x += w - n_hyph * (w / (n_hyph + 1));
+      breaks[n_breaks].x0 = x;
+      breaks[n_breaks].penalty = rand () % 20 ? 0 : rand () % 1000;
+      if (params->tab_width && rand () % 10 == 0)
+	/* Tabs are 0 width breaks. */
+	breaks[n_breaks].flags = HNJ_JUST_FLAG_ISTAB;
+      else
+	{
+	  x += spacewidth;
+	  breaks[n_breaks].flags = rand () % 100 ? HNJ_JUST_FLAG_ISSPACE :
+	    HNJ_JUST_FLAG_ISHARD;
+	}
+      breaks[n_breaks].x1 = x;
+      n_breaks++;
+    }
+  breaks[n_breaks - 1].flags = 0;
+  breaks[n_breaks - 1].penalty = 0;
+  for (i = 1; i < n_breaks; i++)
+    assert (breaks[i].x0 >= breaks[i - 1].x0);
+  return n_breaks;
+}
+
+/* Long paragraphs, for timing hq on one thread against four, best
+   of LONG_RUNS runs each. The lines are of about line_words words of
+   ordinary width, and there are no tabs, hard breaks or overwide
+   words, which would cut the paragraph into independent parts
+   anyway, so the threads only get work from the cuts the search
+   finds for itself. */
+#define N_LONG 3
+#define LONG_WORDS 10000
+#define LONG_RUNS 3
+
+static const int long_line_words[N_LONG] = { 6, 8, 10 };
+
+static int
+gen_long_paragraph (HnjBreak *breaks, int line_words, HnjParams *params)
+{
+  int n_breaks = 0;
+  int x = 0;
+  int i, j;
+  int n_hyph;
+  int w;
+
+  memset (params, 0, sizeof (HnjParams));
+  params->set_width = line_words * 100;
+  params->max_neg_space = 64;
+
+  for (i = 0; i < LONG_WORDS; i++)
+    {
+      w = 10 + rand () % 150;
+      n_hyph = rand () % 4 ? 0 : rand () % 4;
+      if (n_hyph && w / (n_hyph + 1) <= 10)
+	n_hyph = 0;
+      for (j = 0; j < n_hyph; j++)
+	{
+	  x += w / (n_hyph + 1);
+	  breaks[n_breaks].x0 = x + 10;
+	  breaks[n_breaks].x1 = x;
+	  breaks[n_breaks].penalty = 5000 + rand () % 10000;
+	  breaks[n_breaks].flags = HNJ_JUST_FLAG_ISHYPHEN;
+	  n_breaks++;
+	}
+      x += w - n_hyph * (w / (n_hyph + 1));
+      breaks[n_breaks].x0 = x;
+      x += 15;
+      breaks[n_breaks].x1 = x;
+      breaks[n_breaks].penalty = 0;
+      breaks[n_breaks].flags = HNJ_JUST_FLAG_ISSPACE;
+      n_breaks++;
+    }
+  breaks[n_breaks - 1].flags = 0;
+  return n_breaks;
+}
+
+int
+main (int argc, char **argv)
+{
+  int n_paragraphs = 1000;
+  int max_words = 300;
+  unsigned int seed = 1;
+  int verbose = 0;
+  int dense = 0;
+  HnjBreak *breaks;
+  HnjBreak *copy;
+  HnjBreak *pruned;
+  int *map;
+  int *result;
+  HnjParams params;
+  int n_breaks;
+  int n_result;
+  long long ref_cost, cost;
+  int n_failed = 0;
+  long long n_nodes = 0, n_pruned_nodes = 0;
+  long long n_steps = 0, n_pruned_steps = 0;
+  int n_pruned;
+  double t, t_hq, t_threads;
+  int i, j;
+  unsigned int e;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (!strcmp (argv[i], "-n") && i + 1 < argc)
+	n_paragraphs = atoi (argv[++i]);
+      else if (!strcmp (argv[i], "-w") && i + 1 < argc)
+	max_words = atoi (argv[++i]);
+      else if (!strcmp (argv[i], "-s") && i + 1 < argc)
+	seed = strtoul (argv[++i], NULL, 0);
+      else if (!strcmp (argv[i], "-y"))
+	dense = 1;
+      else if (!strcmp (argv[i], "-v"))
+	verbose = 1;
+      else
+	{
+	  fprintf (stderr, "usage: justcheck [-n paragraphs] [-w max-words] "
+		   "[-s seed] [-y] [-v]\n");
+	  return 1;
+	}
+    }
+  if (max_words < 1)
+    max_words = 1;
+
+  /* Up to four breaks per word. */
+  breaks = malloc (max_words * 4 * sizeof (HnjBreak));
+  copy = malloc (max_words * 4 * sizeof (HnjBreak));
+  pruned = malloc (max_words * 4 * sizeof (HnjBreak));
+  map = malloc (max_words * 4 * sizeof (int));
+  result = malloc (max_words * 4 * sizeof (int));
+
+  srand (seed);
+  for (i = 0; i < n_paragraphs; i++)
+    {
+      n_breaks = gen_paragraph (breaks, max_words, dense, &params);
+      ref_cost = 0;
+      for (e = 0; e < N_ENGINES; e++)
+	{
+	  memcpy (copy, breaks, n_breaks * sizeof (HnjBreak));
+	  t = get_time ();
+	  n_result = engines[e].just (copy, n_breaks, &params, result);
+	  engines[e].time += get_time () - t;
+	  cost = path_cost (breaks, n_breaks, &params, result, n_result);
+	  if (e == 0)
+	    ref_cost = cost;
+	  if (cost >= 0)
+	    engines[e].cost += cost;
+	  if (cost < 0 || (engines[e].exact && cost != ref_cost))
+	    {
+	      engines[e].n_mismatches++;
+	      if (engines[e].exact)
+		n_failed++;
+	      if (verbose || engines[e].exact)
+		fprintf (stderr, "paragraph %d (%d breaks): %s cost %lld, "
+			 "reference %lld\n", i, n_breaks, engines[e].name,
+			 cost, ref_cost);
+	    }
+	}
+
+      /* What pruning saves the search. */
+      n_pruned = hnj_prune_breaks (breaks, n_breaks, &params, pruned, map);
+      n_nodes += n_breaks;
+      n_pruned_nodes += n_pruned;
+      n_steps += hnj_hq_just_steps (breaks, n_breaks, &params);
+      n_pruned_steps += hnj_hq_just_steps (pruned, n_pruned, &params);
+    }
+
+  printf ("%d paragraphs of up to %d words, seed %u\n", n_paragraphs,
+	  max_words, seed);
+  printf ("%-12s %12s %10s %16s %10s\n", "engine", "time (ms)", "speedup",
+	  "total penalty", "mismatch");
+  for (e = 0; e < N_ENGINES; e++)
+    printf ("%-12s %12.2f %9.1fx %16lld %10d\n", engines[e].name,
+	    engines[e].time * 1e3,
+	    engines[e].time > 0 ? engines[0].time / engines[e].time : 0,
+	    engines[e].cost, engines[e].n_mismatches);
+  printf ("pruning: %lld of %lld breaks, %lld of %lld search steps left\n",
+	  n_pruned_nodes, n_nodes, n_pruned_steps, n_steps);
+
+  free (breaks);
+  free (copy);
+  free (result);
+  breaks = malloc (LONG_WORDS * 4 * sizeof (HnjBreak));
+  copy = malloc (LONG_WORDS * 4 * sizeof (HnjBreak));
+  result = malloc (LONG_WORDS * 4 * sizeof (int));
+
+  printf ("\n%d paragraphs of %d words, %ld processors\n", N_LONG,
+	  LONG_WORDS, sysconf (_SC_NPROCESSORS_ONLN));
+  printf ("%-12s %12s %12s %10s %10s\n", "words/line", "hq (ms)",
+	  "threads (ms)", "speedup", "mismatch");
+  for (i = 0; i < N_LONG; i++)
+    {
+      n_breaks = gen_long_paragraph (breaks, long_line_words[i], &params);
+      t_hq = t_threads = 0;
+      for (j = 0; j < LONG_RUNS; j++)
+	{
+	  t = get_time ();
+	  n_result = hnj_hq_just (breaks, n_breaks, &params, result);
+	  t = get_time () - t;
+	  if (j == 0 || t < t_hq)
+	    t_hq = t;
+	}
+      ref_cost = path_cost (breaks, n_breaks, &params, result, n_result);
+      for (j = 0; j < LONG_RUNS; j++)
+	{
+	  memcpy (copy, breaks, n_breaks * sizeof (HnjBreak));
+	  t = get_time ();
+	  n_result = hq_threads_just (copy, n_breaks, &params, result);
+	  t = get_time () - t;
+	  if (j == 0 || t < t_threads)
+	    t_threads = t;
+	}
+      cost = path_cost (breaks, n_breaks, &params, result, n_result);
+      if (cost != ref_cost)
+	{
+	  n_failed++;
+	  fprintf (stderr, "long paragraph %d (%d breaks): hq-threads cost "
+		   "%lld, hq %lld\n", i, n_breaks, cost, ref_cost);
+	}
+      printf ("%-12d %12.2f %12.2f %9.1fx %10d\n", long_line_words[i],
+	      t_hq * 1e3, t_threads * 1e3,
+	      t_threads > 0 ? t_hq / t_threads : 0, cost != ref_cost);
+    }
+
+  free (breaks);
+  free (copy);
+  free (pruned);
+  free (map);
+  free (result);
+  return n_failed != 0;
+}
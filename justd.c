@@ -0,0 +1,1176 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* A justification server.
+
+   Usage: justd [-s socket] [-t threads] [-d dict|none] [-f font[,afm[,size]]]...
+
+   The dictionary may be libhyphen patterns or a trie compiled from
+   them by hyphcomp. By default it is hyphen.trie, or failing that
+   hyphen.mashed.
+
+   justd keeps fonts, the hyphenation dictionary, measurement caches
+   and justification workspaces loaded between requests, so that
+   small jobs don't pay for starting up. Each worker thread has its
+   own faces and measurement caches, so TEXT requests never wait for
+   each other. See justd.h for the protocol.
+
+   The main thread does all the socket I/O. Requests that read
+   completely in one round of poll are queued together, and worker
+   threads take them off the queue in batches of up to JUSTD_BATCH,
+   so a burst of small requests costs one wakeup per batch rather than
+   per request. Finished jobs are handed back to the main thread
+   through a pipe. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <hyphen.h>
+#include "hqjust.h"
+#include "autojust.h"
+#include "hsjust.h"
+#include "hyphtrie.h"
+#include "measure.h"
+#include "justd.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+typedef struct _Font Font;
+typedef struct _Job Job;
+typedef struct _Worker Worker;
+typedef struct _Conn Conn;
+typedef struct _Stats Stats;
+typedef struct _Server Server;
+
+#define JUSTD_BATCH 32
+#define JUSTD_MAX_FONTS 64
+#define N_LATENCY_BUCKETS 32
+
+/* A font, measured at a fixed size. Neither a face nor a measure may
+   be used by two threads at once, so each worker opens its own. */
+struct _Font {
+  const char *filename;
+  const char *afm_filename;
+  double size;
+};
+
+/* A request, and once it has been done, its reply. */
+struct _Job {
+  Job *next;
+  int conn_id;
+  int type;
+  int id;
+  char *payload;
+  int size;
+  double t_start;
+  int status;
+  char *reply;
+  int reply_size;
+};
+
+/* A worker thread, its faces and measures of the server's fonts, and
+   its workspace, which is kept between jobs. */
+struct _Worker {
+  pthread_t thread;
+  Server *server;
+  FT_Face faces[JUSTD_MAX_FONTS];
+  HnjMeasure *measures[JUSTD_MAX_FONTS];
+  int size;
+  HnjBreak *breaks;
+  int *result;
+  int *result_flags;
+  HnjLine *lines;
+  int *is;
+  int *js;
+  char **words;
+  int words_size;
+};
+
+/* A client connection. Requests are read into in, and replies
+   written from out. */
+struct _Conn {
+  int fd;
+  int id;
+  char *in;
+  int in_len;
+  int in_size;
+  char *out;
+  int out_pos;
+  int out_len;
+  int out_size;
+};
+
+/* latency[i] counts jobs that took less than 2^i microseconds. */
+struct _Stats {
+  long n_requests[JUSTD_STATS + 1];
+  long n_errors;
+  long n_batches;
+  long n_batched;
+  int max_batch;
+  long latency[N_LATENCY_BUCKETS];
+  double total_latency;
+  long bytes_in;
+  long bytes_out;
+};
+
+struct _Server {
+  FT_Library library;
+  Font fonts[JUSTD_MAX_FONTS];
+  int n_fonts;
+  HyphenDict *dict;
+  HnjHyphTrie *trie;
+
+  /* lock protects everything below. */
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  HnjParams params[JUSTD_MAX_PARAMS];
+  bool params_set[JUSTD_MAX_PARAMS];
+  Job *queue;
+  Job *queue_tail;
+  Job *done;
+  Job *done_tail;
+  bool quit;
+  Stats stats;
+  double t_start;
+
+  int wake_pipe[2];
+};
+
+static volatile sig_atomic_t got_signal = 0;
+
+static void
+handle_signal (int sig)
+{
+  got_signal = 1;
+}
+
+static double
+get_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int32_t
+get_int (const char *p, int i)
+{
+  int32_t v;
+
+  memcpy (&v, p + i * 4, 4);
+  return v;
+}
+
+static void
+put_int (char *p, int i, int32_t v)
+{
+  memcpy (p + i * 4, &v, 4);
+}
+
+/* Make sure the worker's workspace holds n breaks and n_words words. */
+static int
+worker_reserve (Worker *w, int n, int n_words)
+{
+  if (n > w->size)
+    {
+      free (w->breaks);
+      free (w->result);
+      free (w->result_flags);
+      free (w->lines);
+      free (w->is);
+      free (w->js);
+      w->size = n;
+      w->breaks = malloc (n * sizeof (HnjBreak));
+      w->result = malloc (n * sizeof (int));
+      w->result_flags = malloc (n * sizeof (int));
+      w->lines = malloc (n * sizeof (HnjLine));
+      w->is = malloc (n * sizeof (int));
+      w->js = malloc (n * sizeof (int));
+      if (w->breaks == NULL || w->result == NULL ||
+	  w->result_flags == NULL || w->lines == NULL ||
+	  w->is == NULL || w->js == NULL)
+	{
+	  w->size = 0;
+	  return -1;
+	}
+    }
+  if (n_words > w->words_size)
+    {
+      free (w->words);
+      w->words_size = n_words;
+      w->words = malloc (n_words * sizeof (char *));
+      if (w->words == NULL)
+	{
+	  w->words_size = 0;
+	  return -1;
+	}
+    }
+  return 0;
+}
+
+/* Look up params id, returning false if it was never set. */
+static bool
+get_params (Server *server, int id, HnjParams *params)
+{
+  bool ok;
+
+  if (id < 0 || id >= JUSTD_MAX_PARAMS)
+    return false;
+  pthread_mutex_lock (&server->lock);
+  ok = server->params_set[id];
+  if (ok)
+    *params = server->params[id];
+  pthread_mutex_unlock (&server->lock);
+  return ok;
+}
+
+/* Check that params are in range (see just.h), returning false if
+   they aren't. */
+static bool
+check_params (const HnjParams *params)
+{
+  return params->set_width > 0 && params->max_neg_space >= 0 &&
+    params->tab_width >= 0 &&
+    params->max_expand >= 0 && params->max_expand <= 256 &&
+    params->max_shrink >= 0 && params->max_shrink <= 256;
+}
+
+/* Check that params and breaks meet the preconditions of the
+   justifiers (see just.h), returning false if they don't. */
+static bool
+check_breaks (const HnjParams *params, const HnjBreak *breaks, int n_breaks)
+{
+  int i;
+
+  if (!check_params (params))
+    return false;
+  for (i = 0; i < n_breaks; i++)
+    {
+      if (breaks[i].flags & ~(HNJ_JUST_FLAG_ISSPACE | HNJ_JUST_FLAG_ISHYPHEN |
+			      HNJ_JUST_FLAG_ISTAB | HNJ_JUST_FLAG_ISHARD))
+	return false;
+      if (breaks[i].penalty < 0 || breaks[i].x0 < 0)
+	return false;
+      if (i > 0 && breaks[i].x0 < breaks[i - 1].x0)
+	return false;
+      if (breaks[i].flags & HNJ_JUST_FLAG_ISTAB)
+	{
+	  if (params->tab_width == 0 || breaks[i].x1 != breaks[i].x0)
+	    return false;
+	}
+      else if (breaks[i].flags & HNJ_JUST_FLAG_ISHYPHEN)
+	{
+	  if (breaks[i].x1 > breaks[i].x0)
+	    return false;
+	}
+      else if (breaks[i].x1 < breaks[i].x0)
+	return false;
+    }
+  return true;
+}
+
+static void
+do_breaks (Worker *w, Job *job)
+{
+  HnjParams params;
+  int engine;
+  int n_breaks;
+  int n_result;
+  int rest;
+  int i;
+
+  if (job->size < 5 * 4)
+    goto bad;
+  memset (&params, 0, sizeof (params));
+  engine = get_int (job->payload, 0);
+  params.set_width = get_int (job->payload, 1);
+  params.max_neg_space = get_int (job->payload, 2);
+  params.tab_width = get_int (job->payload, 3);
+  n_breaks = get_int (job->payload, 4);
+  if (n_breaks < 0 || n_breaks > (job->size - 5 * 4) / 16)
+    goto bad;
+  /* max_expand and max_shrink may follow the breaks. */
+  rest = job->size - 5 * 4 - n_breaks * 16;
+  if (rest == 2 * 4)
+    {
+      params.max_expand = get_int (job->payload, 5 + 4 * n_breaks);
+      params.max_shrink = get_int (job->payload, 6 + 4 * n_breaks);
+    }
+  else if (rest != 0)
+    goto bad;
+  if (worker_reserve (w, n_breaks, 0))
+    {
+      job->status = JUSTD_ERR_NO_MEMORY;
+      return;
+    }
+  memcpy (w->breaks, job->payload + 5 * 4, n_breaks * sizeof (HnjBreak));
+  if (!check_breaks (&params, w->breaks, n_breaks))
+    goto bad;
+
+  if (engine == JUSTD_ENGINE_HQ)
+    n_result = hnj_hq_just_flags (w->breaks, n_breaks, &params, w->result,
+				  w->result_flags);
+  else if (engine == JUSTD_ENGINE_AUTO)
+    n_result = hnj_just_auto (w->breaks, n_breaks, &params, NULL, w->result,
+			      w->result_flags);
+  else if (engine == JUSTD_ENGINE_HS)
+    {
+      n_result = hnj_hs_just (w->breaks, n_breaks, &params, w->result);
+      for (i = 0; i < n_result; i++)
+	w->result_flags[i] = 0;
+    }
+  else
+    goto bad;
+  if (n_result < 0)
+    {
+      job->status = JUSTD_ERR_NO_MEMORY;
+      return;
+    }
+
+  job->reply_size = (1 + 2 * n_result) * 4;
+  job->reply = malloc (job->reply_size);
+  if (job->reply == NULL)
+    {
+      job->reply_size = 0;
+      job->status = JUSTD_ERR_NO_MEMORY;
+      return;
+    }
+  put_int (job->reply, 0, n_result);
+  for (i = 0; i < n_result; i++)
+    {
+      put_int (job->reply, 1 + i, w->result[i]);
+      put_int (job->reply, 1 + n_result + i, w->result_flags[i]);
+    }
+  return;
+
+bad:
+  job->status = JUSTD_ERR_BAD_REQUEST;
+}
+
+static void
+do_text (Worker *w, Job *job)
+{
+  HnjParams params;
+  HnjMeasure *measure;
+  int font_id;
+  int n_words;
+  int n_breaks;
+  int n_result;
+  int max_breaks;
+  char *p, *end;
+  int i, b;
+
+  if (job->size < 3 * 4)
+    goto bad;
+  font_id = get_int (job->payload, 0);
+  n_words = get_int (job->payload, 2);
+  if (font_id < 0 || font_id >= w->server->n_fonts ||
+      !get_params (w->server, get_int (job->payload, 1), &params))
+    {
+      job->status = JUSTD_ERR_UNKNOWN_ID;
+      return;
+    }
+  if (n_words < 1 || n_words > job->size - 3 * 4 ||
+      job->payload[job->size - 1] != '\0')
+    goto bad;
+
+  /* At most one break per byte of text, and one per word. */
+  max_breaks = job->size - 3 * 4 + n_words;
+  if (worker_reserve (w, max_breaks, n_words))
+    {
+      job->status = JUSTD_ERR_NO_MEMORY;
+      return;
+    }
+  p = job->payload + 3 * 4;
+  end = job->payload + job->size;
+  for (i = 0; i < n_words; i++)
+    {
+      if (p == end)
+	goto bad;
+      w->words[i] = p;
+      p += strlen (p) + 1;
+    }
+
+  /* As psset does, only the words around lines with more than two
+     spaces' worth of slack get hyphenated. max_breaks is enough for
+     every break, so failing means running out of memory. */
+  measure = w->measures[font_id];
+  n_result = hnj_measure_just (measure, w->server->dict, w->words, n_words,
+			       &params,
+			       2 * hnj_measure_char_width (measure, ' '),
+			       w->breaks, w->is, w->js, max_breaks, &n_breaks,
+			       w->result, w->lines);
+  if (n_result < 0)
+    {
+      job->status = JUSTD_ERR_NO_MEMORY;
+      return;
+    }
+
+  job->reply_size = (1 + 4 * n_result) * 4;
+  job->reply = malloc (job->reply_size);
+  if (job->reply == NULL)
+    {
+      job->reply_size = 0;
+      job->status = JUSTD_ERR_NO_MEMORY;
+      return;
+    }
+  put_int (job->reply, 0, n_result);
+  for (i = 0; i < n_result; i++)
+    {
+      b = w->result[i];
+      put_int (job->reply, 1 + 4 * i, w->is[b]);
+      put_int (job->reply, 2 + 4 * i, w->js[b]);
+      put_int (job->reply, 3 + 4 * i, w->lines[i].flags);
+      put_int (job->reply, 4 + 4 * i, w->breaks[b].flags);
+    }
+  return;
+
+bad:
+  job->status = JUSTD_ERR_BAD_REQUEST;
+}
+
+static void *
+worker_main (void *data)
+{
+  Worker *w = data;
+  Server *server = w->server;
+  Job *batch, *job, *last;
+  int n;
+  double t;
+  int bucket;
+  char c = 0;
+
+  for (;;)
+    {
+      pthread_mutex_lock (&server->lock);
+      while (server->queue == NULL && !server->quit)
+	pthread_cond_wait (&server->cond, &server->lock);
+      if (server->quit)
+	{
+	  pthread_mutex_unlock (&server->lock);
+	  return NULL;
+	}
+      batch = server->queue;
+      for (n = 1, last = batch; n < JUSTD_BATCH && last->next; n++)
+	last = last->next;
+      server->queue = last->next;
+      if (server->queue == NULL)
+	server->queue_tail = NULL;
+      last->next = NULL;
+      server->stats.n_batches++;
+      server->stats.n_batched += n;
+      if (n > server->stats.max_batch)
+	server->stats.max_batch = n;
+      pthread_mutex_unlock (&server->lock);
+
+      for (job = batch; job; job = job->next)
+	{
+	  job->status = JUSTD_OK;
+	  if (job->type == JUSTD_BREAKS)
+	    do_breaks (w, job);
+	  else
+	    do_text (w, job);
+	}
+
+      t = get_time ();
+      pthread_mutex_lock (&server->lock);
+      for (job = batch; job; job = job->next)
+	{
+	  double latency = t - job->t_start;
+
+	  for (bucket = 0; bucket < N_LATENCY_BUCKETS - 1 &&
+		 latency * 1e6 >= (1L << bucket); bucket++)
+	    ;
+	  server->stats.latency[bucket]++;
+	  server->stats.total_latency += latency;
+	  if (job->status != JUSTD_OK)
+	    server->stats.n_errors++;
+	}
+      if (server->done_tail)
+	server->done_tail->next = batch;
+      else
+	server->done = batch;
+      server->done_tail = last;
+      pthread_mutex_unlock (&server->lock);
+      if (write (server->wake_pipe[1], &c, 1) < 0 && errno != EAGAIN)
+	perror ("justd: write");
+    }
+}
+
+/* Upper bound of the bucket the fraction q of the latencies fall
+   below, in microseconds. */
+static long
+latency_percentile (const Stats *stats, long n, double q)
+{
+  long count = 0;
+  int i;
+
+  for (i = 0; i < N_LATENCY_BUCKETS; i++)
+    {
+      count += stats->latency[i];
+      if (count >= q * n)
+	break;
+    }
+  return 1L << i;
+}
+
+static void
+do_stats (Server *server, Job *job)
+{
+  Stats stats;
+  double uptime;
+  long n_requests;
+  long n_done;
+  int i;
+
+  pthread_mutex_lock (&server->lock);
+  stats = server->stats;
+  pthread_mutex_unlock (&server->lock);
+
+  uptime = get_time () - server->t_start;
+  n_requests = 0;
+  for (i = 0; i <= JUSTD_STATS; i++)
+    n_requests += stats.n_requests[i];
+  n_done = 0;
+  for (i = 0; i < N_LATENCY_BUCKETS; i++)
+    n_done += stats.latency[i];
+
+  job->reply = malloc (1024);
+  if (job->reply == NULL)
+    {
+      job->status = JUSTD_ERR_NO_MEMORY;
+      return;
+    }
+  job->reply_size =
+    snprintf (job->reply, 1024,
+	      "uptime %.1f s\n"
+	      "requests %ld (breaks %ld, text %ld, params %ld, stats %ld)\n"
+	      "errors %ld\n"
+	      "throughput %.1f requests/s, %.1f kB/s in, %.1f kB/s out\n"
+	      "batches %ld, mean size %.2f, max %d\n"
+	      "latency mean %.0f us, p50 < %ld us, p90 < %ld us, "
+	      "p99 < %ld us\n",
+	      uptime, n_requests, stats.n_requests[JUSTD_BREAKS],
+	      stats.n_requests[JUSTD_TEXT], stats.n_requests[JUSTD_PARAMS],
+	      stats.n_requests[JUSTD_STATS], stats.n_errors,
+	      n_requests / uptime, stats.bytes_in / uptime * 1e-3,
+	      stats.bytes_out / uptime * 1e-3,
+	      stats.n_batches,
+	      stats.n_batches ? (double) stats.n_batched / stats.n_batches : 0,
+	      stats.max_batch,
+	      n_done ? stats.total_latency / n_done * 1e6 : 0,
+	      latency_percentile (&stats, n_done, 0.5),
+	      latency_percentile (&stats, n_done, 0.9),
+	      latency_percentile (&stats, n_done, 0.99));
+  if (job->reply_size > 1023)
+    job->reply_size = 1023;
+}
+
+static void
+do_params (Server *server, Job *job)
+{
+  HnjParams params;
+  int id;
+
+  if (job->size != 4 * 4 && job->size != 6 * 4)
+    {
+      job->status = JUSTD_ERR_BAD_REQUEST;
+      return;
+    }
+  id = get_int (job->payload, 0);
+  if (id < 0 || id >= JUSTD_MAX_PARAMS)
+    {
+      job->status = JUSTD_ERR_UNKNOWN_ID;
+      return;
+    }
+  memset (&params, 0, sizeof (params));
+  params.set_width = get_int (job->payload, 1);
+  params.max_neg_space = get_int (job->payload, 2);
+  params.tab_width = get_int (job->payload, 3);
+  if (job->size == 6 * 4)
+    {
+      params.max_expand = get_int (job->payload, 4);
+      params.max_shrink = get_int (job->payload, 5);
+    }
+  if (!check_params (&params))
+    {
+      job->status = JUSTD_ERR_BAD_REQUEST;
+      return;
+    }
+  pthread_mutex_lock (&server->lock);
+  server->params[id] = params;
+  server->params_set[id] = true;
+  pthread_mutex_unlock (&server->lock);
+}
+
+/* Queue a reply on conn. Returns -1 if out of memory. */
+static int
+conn_reply (Conn *conn, Job *job)
+{
+  int size = 3 * 4 + job->reply_size;
+
+  if (conn->out_len + size > conn->out_size)
+    {
+      char *new_out;
+      int new_size = conn->out_size * 2 + size;
+
+      /* Drop what has been written already. */
+      memmove (conn->out, conn->out + conn->out_pos,
+	       conn->out_len - conn->out_pos);
+      conn->out_len -= conn->out_pos;
+      conn->out_pos = 0;
+      new_out = realloc (conn->out, new_size);
+      if (new_out == NULL)
+	return -1;
+      conn->out = new_out;
+      conn->out_size = new_size;
+    }
+  put_int (conn->out + conn->out_len, 0, job->status);
+  put_int (conn->out + conn->out_len, 1, job->id);
+  put_int (conn->out + conn->out_len, 2, job->reply_size);
+  if (job->reply_size)
+    memcpy (conn->out + conn->out_len + 3 * 4, job->reply, job->reply_size);
+  conn->out_len += size;
+  return 0;
+}
+
+static void
+job_free (Job *job)
+{
+  free (job->payload);
+  free (job->reply);
+  free (job);
+}
+
+/* Parse the complete requests read on conn. PARAMS and STATS are
+   answered right away; the rest are added to the list at *queue.
+   Returns -1 if the connection should be closed. */
+static int
+conn_parse (Server *server, Conn *conn, Job **queue, Job **queue_tail)
+{
+  Job *job;
+  int type, size;
+  int pos = 0;
+  int status = 0;
+
+  while (conn->in_len - pos >= 3 * 4)
+    {
+      type = get_int (conn->in + pos, 0);
+      size = get_int (conn->in + pos, 2);
+      if (type < JUSTD_BREAKS || type > JUSTD_STATS ||
+	  size < 0 || size > JUSTD_MAX_REQUEST)
+	{
+	  status = -1;
+	  break;
+	}
+      if (conn->in_len - pos < 3 * 4 + size)
+	break;
+
+      job = malloc (sizeof (Job));
+      if (job == NULL)
+	{
+	  status = -1;
+	  break;
+	}
+      job->next = NULL;
+      job->conn_id = conn->id;
+      job->type = type;
+      job->id = get_int (conn->in + pos, 1);
+      job->size = size;
+      job->payload = malloc (size + 1);
+      job->t_start = get_time ();
+      job->status = JUSTD_OK;
+      job->reply = NULL;
+      job->reply_size = 0;
+      if (job->payload == NULL)
+	{
+	  free (job);
+	  status = -1;
+	  break;
+	}
+      memcpy (job->payload, conn->in + pos + 3 * 4, size);
+      pos += 3 * 4 + size;
+
+      pthread_mutex_lock (&server->lock);
+      server->stats.n_requests[type]++;
+      server->stats.bytes_in += 3 * 4 + size;
+      pthread_mutex_unlock (&server->lock);
+
+      if (type == JUSTD_PARAMS || type == JUSTD_STATS)
+	{
+	  if (type == JUSTD_PARAMS)
+	    do_params (server, job);
+	  else
+	    do_stats (server, job);
+	  if (conn_reply (conn, job))
+	    status = -1;
+	  job_free (job);
+	  if (status)
+	    break;
+	}
+      else
+	{
+	  if (*queue_tail)
+	    (*queue_tail)->next = job;
+	  else
+	    *queue = job;
+	  *queue_tail = job;
+	}
+    }
+
+  memmove (conn->in, conn->in + pos, conn->in_len - pos);
+  conn->in_len -= pos;
+  return status;
+}
+
+/* Read what's available on conn. Returns -1 on end of file or
+   error. */
+static int
+conn_read (Conn *conn)
+{
+  ssize_t n;
+
+  if (conn->in_size - conn->in_len < 4096)
+    {
+      char *new_in;
+      int new_size = conn->in_size * 2 + 4096;
+
+      new_in = realloc (conn->in, new_size);
+      if (new_in == NULL)
+	return -1;
+      conn->in = new_in;
+      conn->in_size = new_size;
+    }
+  n = read (conn->fd, conn->in + conn->in_len, conn->in_size - conn->in_len);
+  if (n < 0 && (errno == EAGAIN || errno == EINTR))
+    return 0;
+  if (n <= 0)
+    return -1;
+  conn->in_len += n;
+  return 0;
+}
+
+/* Write what can be written on conn. Returns -1 on error. */
+static int
+conn_write (Server *server, Conn *conn)
+{
+  ssize_t n;
+
+  n = write (conn->fd, conn->out + conn->out_pos,
+	     conn->out_len - conn->out_pos);
+  if (n < 0 && (errno == EAGAIN || errno == EINTR))
+    return 0;
+  if (n < 0)
+    return -1;
+  conn->out_pos += n;
+  if (conn->out_pos == conn->out_len)
+    conn->out_pos = conn->out_len = 0;
+  pthread_mutex_lock (&server->lock);
+  server->stats.bytes_out += n;
+  pthread_mutex_unlock (&server->lock);
+  return 0;
+}
+
+static void
+conn_close (Conn *conn)
+{
+  close (conn->fd);
+  free (conn->in);
+  free (conn->out);
+}
+
+/* Add the font spec names to the server's fonts. The fonts are
+   opened by the workers (see worker_open_font); spec must live as
+   long as the server. */
+static int
+load_font (Server *server, char *spec)
+{
+  Font *font;
+  char *afm_fn;
+  char *size_str;
+  double size = 12;
+
+  if (server->n_fonts == JUSTD_MAX_FONTS)
+    return -1;
+
+  afm_fn = strchr (spec, ',');
+  if (afm_fn)
+    {
+      *afm_fn++ = '\0';
+      size_str = strchr (afm_fn, ',');
+      if (size_str)
+	{
+	  *size_str++ = '\0';
+	  size = atof (size_str);
+	}
+    }
+
+  if (size <= 0)
+    return -1;
+  font = &server->fonts[server->n_fonts];
+  font->filename = spec;
+  font->afm_filename = afm_fn && *afm_fn ? afm_fn : NULL;
+  font->size = size;
+  server->n_fonts++;
+  return 0;
+}
+
+/* Open font i of the server for w. FreeType faces can't be opened by
+   two threads at once, so this is done before the workers start. */
+static int
+worker_open_font (Worker *w, int i)
+{
+  Server *server = w->server;
+  Font *font = &server->fonts[i];
+
+  if (FT_New_Face (server->library, font->filename, 0, &w->faces[i]))
+    return -1;
+  if (font->afm_filename && FT_Attach_File (w->faces[i], font->afm_filename))
+    return -1;
+  w->measures[i] = hnj_measure_new (w->faces[i], font->size * JUSTD_SCALE /
+				    w->faces[i]->units_per_EM);
+  if (w->measures[i] == NULL)
+    return -1;
+  if (server->trie)
+    hnj_measure_set_hyph_trie (w->measures[i], server->trie);
+  return 0;
+}
+
+static int
+open_socket (const char *path)
+{
+  struct sockaddr_un addr;
+  int fd;
+
+  if (strlen (path) >= sizeof (addr.sun_path))
+    {
+      fprintf (stderr, "justd: socket path too long\n");
+      return -1;
+    }
+  fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    {
+      perror ("justd: socket");
+      return -1;
+    }
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+  unlink (path);
+  if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+      listen (fd, 64) < 0)
+    {
+      perror ("justd: bind");
+      close (fd);
+      return -1;
+    }
+  fcntl (fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+int
+main (int argc, char **argv)
+{
+  static Server server;
+  const char *socket_fn = "justd.sock";
+  const char *dict_fn = NULL;
+  char default_font[] = "NimbusRoman-Regular.t1,NimbusRoman-Regular.afm,12";
+  int n_thread = 0;
+  Worker *workers;
+  Conn *conns = NULL;
+  int n_conns = 0;
+  int conns_size = 0;
+  int next_conn_id = 0;
+  struct pollfd *pfds = NULL;
+  int listen_fd;
+  Job *queue, *queue_tail;
+  Job *done, *job;
+  char buf[256];
+  int i, j;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (!strcmp (argv[i], "-s") && i + 1 < argc)
+	socket_fn = argv[++i];
+      else if (!strcmp (argv[i], "-t") && i + 1 < argc)
+	n_thread = atoi (argv[++i]);
+      else if (!strcmp (argv[i], "-d") && i + 1 < argc)
+	dict_fn = argv[++i];
+      else if (!strcmp (argv[i], "-f") && i + 1 < argc)
+	{
+	  if (load_font (&server, argv[++i]))
+	    {
+	      fprintf (stderr, "justd: can't load font %s\n", argv[i]);
+	      return 1;
+	    }
+	}
+      else
+	{
+	  fprintf (stderr, "usage: justd [-s socket] [-t threads] [-d dict|none] "
+		   "[-f font[,afm[,size]]]...\n");
+	  return 1;
+	}
+    }
+  if (server.n_fonts == 0 && load_font (&server, default_font))
+    {
+      fprintf (stderr, "justd: can't load the default font\n");
+      return 1;
+    }
+  if (dict_fn == NULL)
+    {
+      server.trie = hnj_hyph_trie_open ("hyphen.trie");
+      dict_fn = "hyphen.mashed";
+    }
+  else if (strcmp (dict_fn, "none"))
+    server.trie = hnj_hyph_trie_open (dict_fn);
+  if (server.trie == NULL && strcmp (dict_fn, "none"))
+    server.dict = hnj_hyphen_load (dict_fn);
+  if (server.dict == NULL && server.trie == NULL && strcmp (dict_fn, "none"))
+    fprintf (stderr, "justd: can't load %s, not hyphenating\n", dict_fn);
+
+  if (n_thread <= 0)
+    n_thread = sysconf (_SC_NPROCESSORS_ONLN);
+  if (n_thread <= 0)
+    n_thread = 1;
+
+  if (FT_Init_FreeType (&server.library))
+    {
+      fprintf (stderr, "justd: can't initialize FreeType\n");
+      return 1;
+    }
+  workers = calloc (n_thread, sizeof (Worker));
+  if (workers == NULL)
+    {
+      fprintf (stderr, "justd: out of memory\n");
+      return 1;
+    }
+  for (i = 0; i < n_thread; i++)
+    {
+      workers[i].server = &server;
+      for (j = 0; j < server.n_fonts; j++)
+	if (worker_open_font (&workers[i], j))
+	  {
+	    fprintf (stderr, "justd: can't load font %s\n",
+		     server.fonts[j].filename);
+	    return 1;
+	  }
+    }
+  /* Room for the listening socket and the wake pipe; it grows with
+     conns. */
+  pfds = malloc (2 * sizeof (struct pollfd));
+  if (pfds == NULL)
+    {
+      fprintf (stderr, "justd: out of memory\n");
+      return 1;
+    }
+
+  pthread_mutex_init (&server.lock, NULL);
+  pthread_cond_init (&server.cond, NULL);
+  server.t_start = get_time ();
+  if (pipe (server.wake_pipe) < 0)
+    {
+      perror ("justd: pipe");
+      return 1;
+    }
+  fcntl (server.wake_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl (server.wake_pipe[1], F_SETFL, O_NONBLOCK);
+
+  listen_fd = open_socket (socket_fn);
+  if (listen_fd < 0)
+    return 1;
+
+  signal (SIGPIPE, SIG_IGN);
+  signal (SIGINT, handle_signal);
+  signal (SIGTERM, handle_signal);
+
+  for (i = 0; i < n_thread; i++)
+    if (pthread_create (&workers[i].thread, NULL, worker_main, &workers[i]))
+      break;
+  if (i == 0)
+    {
+      fprintf (stderr, "justd: can't start any workers\n");
+      return 1;
+    }
+  n_thread = i;
+
+  while (!got_signal)
+    {
+      pfds[0].fd = listen_fd;
+      pfds[0].events = POLLIN;
+      pfds[1].fd = server.wake_pipe[0];
+      pfds[1].events = POLLIN;
+      for (i = 0; i < n_conns; i++)
+	{
+	  pfds[i + 2].fd = conns[i].fd;
+	  pfds[i + 2].events = POLLIN;
+	  if (conns[i].out_len > conns[i].out_pos)
+	    pfds[i + 2].events |= POLLOUT;
+	}
+      if (poll (pfds, n_conns + 2, -1) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  perror ("justd: poll");
+	  break;
+	}
+
+      /* Hand finished jobs to their connections. */
+      if (pfds[1].revents & POLLIN)
+	{
+	  while (read (server.wake_pipe[0], buf, sizeof (buf)) > 0)
+	    ;
+	  pthread_mutex_lock (&server.lock);
+	  done = server.done;
+	  server.done = server.done_tail = NULL;
+	  pthread_mutex_unlock (&server.lock);
+	  while (done)
+	    {
+	      job = done;
+	      done = job->next;
+	      for (i = 0; i < n_conns; i++)
+		if (conns[i].id == job->conn_id)
+		  {
+		    if (conn_reply (&conns[i], job))
+		      conns[i].id = -1;
+		    break;
+		  }
+	      job_free (job);
+	    }
+	}
+
+      queue = queue_tail = NULL;
+      for (i = 0; i < n_conns; i++)
+	{
+	  Conn *conn = &conns[i];
+
+	  if (conn->id < 0)
+	    continue;
+	  if ((pfds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) &&
+	      (conn_read (conn) || conn_parse (&server, conn, &queue,
+					       &queue_tail)))
+	    conn->id = -1;
+	  else if ((pfds[i + 2].revents & POLLOUT) &&
+		   conn_write (&server, conn))
+	    conn->id = -1;
+	}
+
+      /* Queue everything read this round at once. */
+      if (queue)
+	{
+	  pthread_mutex_lock (&server.lock);
+	  if (server.queue_tail)
+	    server.queue_tail->next = queue;
+	  else
+	    server.queue = queue;
+	  server.queue_tail = queue_tail;
+	  pthread_cond_broadcast (&server.cond);
+	  pthread_mutex_unlock (&server.lock);
+	}
+
+      /* Drop closed connections. Their jobs' replies are discarded
+	 when they finish. */
+      for (i = j = 0; i < n_conns; i++)
+	if (conns[i].id < 0)
+	  conn_close (&conns[i]);
+	else
+	  conns[j++] = conns[i];
+      n_conns = j;
+
+      if (pfds[0].revents & POLLIN)
+	{
+	  int fd;
+
+	  while ((fd = accept (listen_fd, NULL, NULL)) >= 0)
+	    {
+	      if (n_conns == conns_size)
+		{
+		  int new_size = conns_size * 2 + 16;
+		  Conn *new_conns;
+		  struct pollfd *new_pfds;
+
+		  /* Turn the connection away rather than grow into
+		     nothing; the ones already open carry on. */
+		  new_pfds = realloc (pfds, (new_size + 2) *
+				      sizeof (struct pollfd));
+		  if (new_pfds)
+		    pfds = new_pfds;
+		  new_conns = realloc (conns, new_size * sizeof (Conn));
+		  if (new_pfds == NULL || new_conns == NULL)
+		    {
+		      if (new_conns)
+			conns = new_conns;
+		      fprintf (stderr, "justd: out of memory, "
+			       "refusing connection\n");
+		      close (fd);
+		      continue;
+		    }
+		  conns = new_conns;
+		  conns_size = new_size;
+		}
+	      fcntl (fd, F_SETFL, O_NONBLOCK);
+	      memset (&conns[n_conns], 0, sizeof (Conn));
+	      conns[n_conns].fd = fd;
+	      conns[n_conns].id = next_conn_id++;
+	      n_conns++;
+	    }
+	}
+    }
+
+  pthread_mutex_lock (&server.lock);
+  server.quit = true;
+  pthread_cond_broadcast (&server.cond);
+  pthread_mutex_unlock (&server.lock);
+  for (i = 0; i < n_thread; i++)
+    pthread_join (workers[i].thread, NULL);
+
+  for (i = 0; i < n_conns; i++)
+    conn_close (&conns[i]);
+  close (listen_fd);
+  unlink (socket_fn);
+  return 0;
+}
@@ -0,0 +1,106 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_JUSTD_H__
+#define __HNJ_JUSTD_H__
+
+/* The justd protocol.
+
+   Clients connect to justd's Unix socket and send requests, each a
+   header of three int32 (type, id, size) followed by size bytes of
+   payload. All integers are native byte order int32. Each request
+   gets a reply with a header of (status, id, size) and size bytes of
+   payload; id is copied from the request. Replies to BREAKS and TEXT
+   requests come back in the order they finish, which need not be the
+   order they were sent in.
+
+   JUSTD_BREAKS justifies a list of breaks. Payload: engine
+   (JUSTD_ENGINE_*), set_width, max_neg_space, tab_width, n_breaks,
+   then x0, x1, penalty, flags of each break, and optionally
+   max_expand and max_shrink (see HnjParams; 0 if left out). Reply:
+   n_result, the result, then the HNJ_JUST_LINE_* flags of each line.
+   Requests whose breaks don't meet the preconditions in just.h get
+   JUSTD_ERR_BAD_REQUEST: flags other than HNJ_JUST_FLAG_*, negative
+   penalties, x0 going backwards, spaces narrower than nothing
+   (x1 < x0), hyphens with x1 > x0, and tabs with x1 != x0 or a
+   tab_width of 0. set_width must be positive, max_neg_space and
+   tab_width not negative, and max_expand and max_shrink from 0 to
+   256.
+
+   JUSTD_ENGINE_AUTO picks the justifier with hnj_just_auto, using the
+   profile named by LIBJUSTIFY_PROFILE when justd was started.
+
+   JUSTD_TEXT measures, hyphenates and justifies a paragraph of text,
+   with hnj_measure_just: only the words around lines with more than
+   two spaces' worth of slack are hyphenated. Payload: font id, params id, n_words, then the words as
+   NUL-terminated UTF-8. Font ids number the fonts justd was started
+   with; params ids refer to JUSTD_PARAMS requests. Widths are in
+   1/JUSTD_SCALE points. Reply: n_lines, then for each line the
+   word and byte offset in it where the line ends, the
+   HNJ_JUST_LINE_* flags and the HNJ_JUST_FLAG_* flags of the break.
+
+   JUSTD_PARAMS sets params id to (set_width, max_neg_space,
+   tab_width, max_expand, max_shrink). Payload: id, set_width,
+   max_neg_space, tab_width, and optionally max_expand and max_shrink
+   (0 if left out), in the ranges BREAKS requires. Empty reply.
+
+   The replies to BREAKS and TEXT don't carry the font expansion of
+   the lines; with max_expand or max_shrink set, clients work it out
+   as hnj_hq_just_lines does (see HnjLine).
+
+   JUSTD_STATS returns request counts, batching, latency and
+   throughput statistics as text. Empty payload. */
+
+#define JUSTD_BREAKS 1
+#define JUSTD_TEXT 2
+#define JUSTD_PARAMS 3
+#define JUSTD_STATS 4
+
+#define JUSTD_ENGINE_HQ 1
+#define JUSTD_ENGINE_HS 2
+#define JUSTD_ENGINE_AUTO 3
+
+#define JUSTD_OK 0
+#define JUSTD_ERR_BAD_REQUEST -1
+#define JUSTD_ERR_NO_MEMORY -2
+#define JUSTD_ERR_UNKNOWN_ID -3
+
+#define JUSTD_SCALE 50
+#define JUSTD_MAX_PARAMS 256
+
+/* Bigger requests close the connection. */
+#define JUSTD_MAX_REQUEST (64 << 20)
+
+#endif /* __HNJ_JUSTD_H__ */
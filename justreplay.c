@@ -0,0 +1,241 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Replay captured justification calls (see capture.h) with timing, to
+   reproduce slowdowns offline.
+
+   Usage: justreplay [-n iterations] [-e hq|hs] capture-file...
+
+   Each record is run through the engine it was captured from (or the
+   one given with -e) the given number of times. The best time is
+   reported, along with whether the result matches the captured one. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hqjust.h"
+#include "hsjust.h"
+#include "breakpack.h"
+#include "capture.h"
+
+static double
+get_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Replay one record, returning the best time in seconds, or -1 on
+   error. *mismatch is set if the result differs from the captured
+   one. */
+static double
+replay (const HnjCapture *capture, int engine, int n_iter, int *n_lines,
+	int *mismatch)
+{
+  HnjPackedReader reader;
+  HnjBreak *breaks;
+  HnjBreak *copy;
+  int *result;
+  int n_breaks = capture->packed.n_breaks;
+  int n_result;
+  double best, t;
+  int i;
+
+  breaks = malloc ((n_breaks + 1) * sizeof (HnjBreak));
+  copy = malloc ((n_breaks + 1) * sizeof (HnjBreak));
+  result = malloc ((n_breaks + 1) * sizeof (int));
+  if (breaks == NULL || copy == NULL || result == NULL)
+    {
+      free (breaks);
+      free (copy);
+      free (result);
+      return -1;
+    }
+  hnj_packed_reader_init (&reader, &capture->packed, 0);
+  hnj_packed_reader_read (&reader, breaks, n_breaks);
+
+  best = -1;
+  n_result = 0;
+  for (i = 0; i < n_iter; i++)
+    {
+      /* hnj_hs_just changes the penalties, so always start from a
+	 fresh copy. */
+      memcpy (copy, breaks, n_breaks * sizeof (HnjBreak));
+      t = get_time ();
+      if (engine == HNJ_CAPTURE_HS)
+	n_result = hnj_hs_just (copy, n_breaks, &capture->params, result);
+      else
+	n_result = hnj_hq_just (copy, n_breaks, &capture->params, result);
+      t = get_time () - t;
+      if (best < 0 || t < best)
+	best = t;
+    }
+
+  *n_lines = n_result;
+  *mismatch = 0;
+  if (capture->result && engine == capture->engine &&
+      (n_result != capture->n_result ||
+       memcmp (result, capture->result, n_result * sizeof (int))))
+    *mismatch = 1;
+
+  free (breaks);
+  free (copy);
+  free (result);
+  return best;
+}
+
+static int
+replay_file (const char *fn, int engine, int n_iter, double *total_time,
+	     int *n_records, int *n_mismatches)
+{
+  int fd;
+  struct stat st;
+  const char *data;
+  size_t off;
+  long rec_size;
+  HnjCapture capture;
+  int rec_engine;
+  int n_lines;
+  int mismatch;
+  double t;
+  int rec_idx;
+
+  fd = open (fn, O_RDONLY);
+  if (fd < 0 || fstat (fd, &st) < 0)
+    {
+      perror (fn);
+      if (fd >= 0)
+	close (fd);
+      return -1;
+    }
+  if (st.st_size == 0)
+    {
+      close (fd);
+      return 0;
+    }
+  data = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      perror (fn);
+      return -1;
+    }
+
+  off = 0;
+  for (rec_idx = 0; ; rec_idx++)
+    {
+      rec_size = hnj_capture_parse (data + off, st.st_size - off, &capture);
+      if (rec_size == 0)
+	break;
+      if (rec_size < 0)
+	{
+	  fprintf (stderr, "%s: bad record at offset %lu\n", fn,
+		   (unsigned long) off);
+	  break;
+	}
+      off += rec_size;
+
+      rec_engine = engine ? engine : capture.engine;
+      t = replay (&capture, rec_engine, n_iter, &n_lines, &mismatch);
+      if (t < 0)
+	{
+	  fprintf (stderr, "%s: out of memory\n", fn);
+	  break;
+	}
+      printf ("%s:%d %s breaks=%d lines=%d time=%.1fus%s\n", fn, rec_idx,
+	      rec_engine == HNJ_CAPTURE_HS ? "hs" : "hq",
+	      capture.packed.n_breaks, n_lines, t * 1e6,
+	      mismatch ? " MISMATCH" : "");
+      *total_time += t;
+      (*n_records)++;
+      *n_mismatches += mismatch;
+    }
+
+  munmap ((void *) data, st.st_size);
+  return 0;
+}
+
+int
+main (int argc, char **argv)
+{
+  int n_iter = 10;
+  int engine = 0;
+  double total_time = 0;
+  int n_records = 0;
+  int n_mismatches = 0;
+  int status = 0;
+  int bad_args = 0;
+  int i;
+
+  for (i = 1; i < argc && argv[i][0] == '-' && !bad_args; i++)
+    {
+      if (!strcmp (argv[i], "-n") && i + 1 < argc)
+	n_iter = atoi (argv[++i]);
+      else if (!strcmp (argv[i], "-e") && i + 1 < argc)
+	{
+	  i++;
+	  if (!strcmp (argv[i], "hq"))
+	    engine = HNJ_CAPTURE_HQ;
+	  else if (!strcmp (argv[i], "hs"))
+	    engine = HNJ_CAPTURE_HS;
+	  else
+	    bad_args = 1;
+	}
+      else
+	bad_args = 1;
+    }
+  if (bad_args || i == argc || n_iter < 1)
+    {
+      fprintf (stderr,
+	       "usage: justreplay [-n iterations] [-e hq|hs] capture-file...\n");
+      return 1;
+    }
+
+  for (; i < argc; i++)
+    if (replay_file (argv[i], engine, n_iter, &total_time, &n_records,
+		     &n_mismatches))
+      status = 1;
+
+  printf ("%d records, %.1fus total, %d mismatches\n", n_records,
+	  total_time * 1e6, n_mismatches);
+  return status || n_mismatches;
+}
@@ -0,0 +1,390 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Calibration of hnj_just_auto.
+
+   Usage: justtune [-o profile] [-s scale] [-v]
+
+   Times the justifiers hnj_just_auto chooses from on synthetic
+   paragraphs over a grid of paragraph features, and works out the
+   thresholds of an HnjJustProfile for this machine. The profile is
+   printed, and written to the file given with -o; point
+   LIBJUSTIFY_PROFILE at that file to use it. -s scales the amount of
+   text timed for each point of the grid (default 1), and -v prints
+   the timings.
+
+   The paragraphs look like text set by psset at 10 point: words of
+   20 to 60 points with a 25 point space, and hyphens of 3.4 points
+   with a penalty of 1000000, in units of 1/50 point. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "autojust.h"
+#include "hqjust.h"
+#include "hsjust.h"
+
+#define WORD_MIN 1000
+#define WORD_MAX 3000
+#define SPACE_WIDTH 1250
+#define HYPHEN_WIDTH 170
+#define HYPHEN_PENALTY 1000000
+
+/* Words timed for each point of the grid, at scale 1. */
+#define WORDS_PER_POINT 20000
+
+static const int grid_hyphens[] = { 0, 100, 200, 300, 450, 600 };
+static const int grid_line_words[] = { 3, 5, 8, 12, 16 };
+
+#define N_HYPHENS (sizeof (grid_hyphens) / sizeof (grid_hyphens[0]))
+#define N_LINE_WORDS (sizeof (grid_line_words) / sizeof (grid_line_words[0]))
+
+/* Paragraph lengths tried for hnj_hs_just, in lines. */
+#define GREEDY_MAX_LINES 4
+
+/* Paragraph sizes tried for threading, in breaks. */
+#define PARALLEL_MIN_SIZE 256
+#define PARALLEL_MAX_SIZE 131072
+
+static int verbose;
+
+static double
+get_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Generate a paragraph of n_words words with about hyphens hyphen
+   breaks per 1000 breaks, and a hard break every hard_every words if
+   that isn't 0. Returns the number of breaks; breaks must have room
+   for 3 per word. */
+static int
+gen_paragraph (HnjBreak *breaks, int n_words, int hyphens, int hard_every)
+{
+  /* Hyphen points per word, in 1/1000. */
+  int per_word = hyphens * 1000 / (1000 - hyphens);
+  int n_breaks = 0;
+  int x = 0;
+  int n_hyph;
+  int w;
+  int i, j;
+
+  for (i = 0; i < n_words; i++)
+    {
+      w = WORD_MIN + rand () % (WORD_MAX - WORD_MIN);
+      n_hyph = per_word / 1000 + (rand () % 1000 < per_word % 1000);
+      /* Keep the x0 in order. */
+      if (w / (n_hyph + 1) <= HYPHEN_WIDTH)
+	n_hyph = 0;
+      for (j = 0; j < n_hyph; j++)
+	{
+	  x += w / (n_hyph + 1);
+	  breaks[n_breaks].x0 = x + HYPHEN_WIDTH;
+	  breaks[n_breaks].x1 = x;
+	  breaks[n_breaks].penalty = HYPHEN_PENALTY;
+	  breaks[n_breaks].flags = HNJ_JUST_FLAG_ISHYPHEN;
+	  n_breaks++;
+	}
+      x += w - n_hyph * (w / (n_hyph + 1));
+      breaks[n_breaks].x0 = x;
+      x += SPACE_WIDTH;
+      breaks[n_breaks].x1 = x;
+      breaks[n_breaks].penalty = 0;
+      breaks[n_breaks].flags = hard_every && i % hard_every == hard_every - 1 ?
+	HNJ_JUST_FLAG_ISHARD : HNJ_JUST_FLAG_ISSPACE;
+      n_breaks++;
+    }
+  breaks[n_breaks - 1].flags = 0;
+  return n_breaks;
+}
+
+static void
+init_params (HnjParams *params, int line_words)
+{
+  memset (params, 0, sizeof (HnjParams));
+  params->set_width = line_words * ((WORD_MIN + WORD_MAX) / 2 + SPACE_WIDTH);
+  params->max_neg_space = 128;
+}
+
+/* Time justifying the n_paragraphs paragraphs in breaks (n_breaks[i]
+   in paragraph i, at i * max_breaks) with engine, taking the best of
+   three runs. */
+static double
+time_engine (int engine, HnjBreak *breaks, const int *n_breaks,
+	     int n_paragraphs, int max_breaks, const HnjParams *params,
+	     int *result)
+{
+  double best = -1;
+  double t;
+  int run, i;
+
+  for (run = 0; run < 3; run++)
+    {
+      t = get_time ();
+      for (i = 0; i < n_paragraphs; i++)
+	{
+	  /* hnj_hs_just only changes the penalties of breaks out of
+	     order, and there are none. */
+	  if (engine == HNJ_ENGINE_HS)
+	    hnj_hs_just (breaks + i * max_breaks, n_breaks[i], params,
+			 result);
+	  else
+	    hnj_hq_just_threads (breaks + i * max_breaks, n_breaks[i], params,
+				 engine == HNJ_ENGINE_HQ_PARALLEL ? -1 : 1,
+				 result, NULL);
+	}
+      t = get_time () - t;
+      if (best < 0 || t < best)
+	best = t;
+    }
+  return best;
+}
+
+/* The total cost of the results of engine for the same paragraphs,
+   as hnj_hq_just counts it. */
+static long long
+engine_cost (int engine, HnjBreak *breaks, const int *n_breaks,
+	     int n_paragraphs, int max_breaks, const HnjParams *params,
+	     int *result, HnjLine *lines)
+{
+  long long cost = 0;
+  int n_result;
+  int i, j;
+
+  for (i = 0; i < n_paragraphs; i++)
+    {
+      if (engine == HNJ_ENGINE_HS)
+	n_result = hnj_hs_just_lines (breaks + i * max_breaks, n_breaks[i],
+				      params, result, lines);
+      else
+	n_result = hnj_hq_just_lines (breaks + i * max_breaks, n_breaks[i],
+				      params, result, lines);
+      for (j = 0; j < n_result; j++)
+	cost += lines[j].penalty;
+    }
+  return cost;
+}
+
+/* Find how many lines a paragraph may have for hnj_hs_just to find
+   the same result as hnj_hq_just, faster, all over the grid. The
+   paragraphs of each point of the grid have the number of lines
+   hnj_just_features gives them. */
+static void
+tune_greedy (HnjJustProfile *profile, double scale)
+{
+  HnjParams params;
+  HnjJustFeatures features;
+  HnjBreak *breaks;
+  HnjLine *lines;
+  int *n_breaks;
+  int *result;
+  int n_words, n_paragraphs, max_breaks;
+  double t_hq, t_hs;
+  long long cost_hq, cost_hs;
+  int ok;
+  unsigned int h, w;
+  int l, i;
+
+  profile->greedy_max_lines = 0;
+  for (l = 1; l <= GREEDY_MAX_LINES; l++)
+    {
+      ok = 1;
+      for (h = 0; h < N_HYPHENS; h++)
+	for (w = 0; w < N_LINE_WORDS; w++)
+	  {
+	    init_params (&params, grid_line_words[w]);
+	    /* A little under l lines, at the average word width. */
+	    n_words = l * grid_line_words[w] - 1;
+	    if (n_words < 1)
+	      n_words = 1;
+	    n_paragraphs = WORDS_PER_POINT * scale / n_words;
+	    if (n_paragraphs < 1)
+	      n_paragraphs = 1;
+	    max_breaks = n_words * 3;
+	    breaks = malloc (n_paragraphs * max_breaks * sizeof (HnjBreak));
+	    n_breaks = malloc (n_paragraphs * sizeof (int));
+	    result = malloc (max_breaks * sizeof (int));
+	    lines = malloc (max_breaks * sizeof (HnjLine));
+	    if (breaks == NULL || n_breaks == NULL || result == NULL ||
+		lines == NULL)
+	      {
+		fprintf (stderr, "justtune: out of memory\n");
+		exit (1);
+	      }
+	    srand (l * 10000 + h * 100 + w);
+	    for (i = 0; i < n_paragraphs; i++)
+	      do
+		{
+		  n_breaks[i] = gen_paragraph (breaks + i * max_breaks,
+					       n_words, grid_hyphens[h], 0);
+		  hnj_just_features (breaks + i * max_breaks, n_breaks[i],
+				     &params, &features);
+		}
+	      while (features.n_lines != l);
+	    t_hq = time_engine (HNJ_ENGINE_HQ, breaks, n_breaks, n_paragraphs,
+				max_breaks, &params, result);
+	    t_hs = time_engine (HNJ_ENGINE_HS, breaks, n_breaks, n_paragraphs,
+				max_breaks, &params, result);
+	    cost_hq = engine_cost (HNJ_ENGINE_HQ, breaks, n_breaks,
+				   n_paragraphs, max_breaks, &params, result,
+				   lines);
+	    cost_hs = engine_cost (HNJ_ENGINE_HS, breaks, n_breaks,
+				   n_paragraphs, max_breaks, &params, result,
+				   lines);
+	    if (verbose)
+	      printf ("lines %d hyphens %3d words/line %2d: hq %8.2f ms, "
+		      "hs %8.2f ms, %s\n", l, grid_hyphens[h],
+		      grid_line_words[w], t_hq * 1e3, t_hs * 1e3,
+		      cost_hs == cost_hq ? "same" : "worse");
+	    if (cost_hs != cost_hq || t_hs >= t_hq)
+	      ok = 0;
+	    free (breaks);
+	    free (n_breaks);
+	    free (result);
+	    free (lines);
+	  }
+      if (!ok)
+	break;
+      profile->greedy_max_lines = l;
+    }
+}
+
+/* Find the smallest paragraph from which on threads are faster, for
+   paragraphs of a few lines between hard breaks, or -1 if they never
+   are (as on a single processor). */
+static void
+tune_threads (HnjJustProfile *profile, double scale)
+{
+  HnjParams params;
+  HnjBreak *breaks;
+  int n_breaks;
+  int *result;
+  int n_words, n_paragraphs;
+  double t_hq, t_parallel;
+  int size;
+  int i;
+
+  profile->parallel_min_breaks = -1;
+  if (sysconf (_SC_NPROCESSORS_ONLN) < 2)
+    {
+      if (verbose)
+	printf ("one processor: no threads\n");
+      return;
+    }
+  init_params (&params, 10);
+  for (size = PARALLEL_MIN_SIZE; size <= PARALLEL_MAX_SIZE; size *= 2)
+    {
+      /* About 1.1 breaks per word at 100 hyphens per 1000. */
+      n_words = size * 10 / 11;
+      n_paragraphs = 8 * WORDS_PER_POINT * scale / n_words;
+      if (n_paragraphs < 1)
+	n_paragraphs = 1;
+      breaks = malloc (n_words * 3 * sizeof (HnjBreak));
+      result = malloc (n_words * 3 * sizeof (int));
+      if (breaks == NULL || result == NULL)
+	{
+	  fprintf (stderr, "justtune: out of memory\n");
+	  exit (1);
+	}
+      srand (size);
+      n_breaks = gen_paragraph (breaks, n_words, 100, 40);
+      t_hq = 0;
+      t_parallel = 0;
+      for (i = 0; i < n_paragraphs; i++)
+	{
+	  t_hq += time_engine (HNJ_ENGINE_HQ, breaks, &n_breaks, 1, 0,
+			       &params, result);
+	  t_parallel += time_engine (HNJ_ENGINE_HQ_PARALLEL, breaks,
+				     &n_breaks, 1, 0, &params, result);
+	}
+      if (verbose)
+	printf ("%6d breaks: hq %8.2f ms, parallel %8.2f ms\n", n_breaks,
+		t_hq * 1e3, t_parallel * 1e3);
+      /* By a tenth, so that noise doesn't pass for a gain. */
+      if (t_parallel < t_hq * 0.9)
+	{
+	  if (profile->parallel_min_breaks < 0)
+	    profile->parallel_min_breaks = size;
+	}
+      else
+	profile->parallel_min_breaks = -1;
+      free (breaks);
+      free (result);
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+  HnjJustProfile profile;
+  const char *filename = NULL;
+  double scale = 1;
+  int i;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (!strcmp (argv[i], "-o") && i + 1 < argc)
+	filename = argv[++i];
+      else if (!strcmp (argv[i], "-s") && i + 1 < argc)
+	scale = atof (argv[++i]);
+      else if (!strcmp (argv[i], "-v"))
+	verbose = 1;
+      else
+	{
+	  fprintf (stderr, "usage: justtune [-o profile] [-s scale] [-v]\n");
+	  return 1;
+	}
+    }
+  if (scale <= 0)
+    scale = 1;
+
+  hnj_just_profile_init (&profile);
+  tune_greedy (&profile, scale);
+  tune_threads (&profile, scale);
+
+  printf ("greedy_max_lines %d\n", profile.greedy_max_lines);
+  printf ("parallel_min_breaks %d\n", profile.parallel_min_breaks);
+  if (filename && hnj_just_profile_save (&profile, filename))
+    {
+      fprintf (stderr, "justtune: can't write %s\n", filename);
+      return 1;
+    }
+  return 0;
+}
@@ -0,0 +1,742 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Text measurement and break building. See measure.h. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "measure.h"
+#include "autojust.h"
+#include "trace.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include FT_ADVANCES_H
+
+typedef struct _WidthEntry WidthEntry;
+typedef struct _KernEntry KernEntry;
+
+/* Hyphenation is timed word by word, so it is only counted, once per
+   paragraph, as is the rest of the measuring. */
+HNJ_TRACE_STAGE (hyphenate_stage, "hyphenate");
+HNJ_TRACE_STAGE (metrics_stage, "metrics");
+
+/* Cached width of a cluster. n_cps is 0 for an empty slot. */
+struct _WidthEntry {
+  int n_cps;
+  unsigned int cps[HNJ_CLUSTER_MAX];
+  int width;
+};
+
+/* Cached kerning between the last code point of a cluster and the
+   first of the next. */
+struct _KernEntry {
+  unsigned int c1;
+  unsigned int c2;
+  int kern;
+  bool used;
+};
+
+/* The caches are open addressing hash tables, sizes a power of two. */
+struct _HnjMeasure {
+  FT_Face face;
+  double scale;
+  WidthEntry *widths;
+  int n_widths;
+  int widths_size;
+  KernEntry *kerns;
+  int n_kerns;
+  int kerns_size;
+
+  /* Direct tables for ASCII, which most text is: ascii_widths[c], and
+     ascii_kerns[c1 << 7 | c2], KERN_UNKNOWN until looked up. */
+  int *ascii_widths;
+  int *ascii_kerns;
+
+  /* Word and space widths, for measure_paragraph. */
+  int *xs;
+  int xs_size;
+
+  const HnjHyphTrie *trie;
+};
+
+#define KERN_UNKNOWN INT_MIN
+
+HnjMeasure *
+hnj_measure_new (FT_Face face, double scale)
+{
+  HnjMeasure *m;
+
+  m = malloc (sizeof (HnjMeasure));
+  if (m == NULL)
+    return NULL;
+  m->face = face;
+  m->scale = scale;
+  m->widths = NULL;
+  m->n_widths = 0;
+  m->widths_size = 0;
+  m->kerns = NULL;
+  m->n_kerns = 0;
+  m->kerns_size = 0;
+  m->ascii_widths = NULL;
+  m->ascii_kerns = NULL;
+  m->xs = NULL;
+  m->xs_size = 0;
+  m->trie = NULL;
+  return m;
+}
+
+void
+hnj_measure_free (HnjMeasure *m)
+{
+  if (m == NULL)
+    return;
+  free (m->widths);
+  free (m->kerns);
+  free (m->ascii_widths);
+  free (m->ascii_kerns);
+  free (m->xs);
+  free (m);
+}
+
+void
+hnj_measure_set_hyph_trie (HnjMeasure *m, const HnjHyphTrie *trie)
+{
+  m->trie = trie;
+}
+
+/* Set up the direct tables, and room in xs for n_words words. */
+static int
+measure_reserve (HnjMeasure *m, int n_words)
+{
+  int c;
+
+  if (m->ascii_widths == NULL)
+    {
+      m->ascii_widths = malloc (128 * sizeof (int));
+      m->ascii_kerns = malloc (128 * 128 * sizeof (int));
+      if (m->ascii_widths == NULL || m->ascii_kerns == NULL)
+	{
+	  free (m->ascii_widths);
+	  free (m->ascii_kerns);
+	  m->ascii_widths = m->ascii_kerns = NULL;
+	  return -1;
+	}
+      for (c = 0; c < 128; c++)
+	m->ascii_widths[c] = hnj_measure_char_width (m, c);
+      for (c = 0; c < 128 * 128; c++)
+	m->ascii_kerns[c] = KERN_UNKNOWN;
+    }
+  if (2 * n_words > m->xs_size)
+    {
+      free (m->xs);
+      m->xs_size = 2 * n_words;
+      m->xs = malloc (m->xs_size * sizeof (int));
+      if (m->xs == NULL)
+	{
+	  m->xs_size = 0;
+	  return -1;
+	}
+    }
+  return 0;
+}
+
+/* get xamt of kern pair */
+static int
+measure_kern_pair (HnjMeasure *m, unsigned int c1, unsigned int c2)
+{
+  unsigned int glyph1, glyph2;
+  FT_Vector kern;
+
+  glyph1 = FT_Get_Char_Index (m->face, c1);
+  glyph2 = FT_Get_Char_Index (m->face, c2);
+  if (FT_Get_Kerning (m->face, glyph1, glyph2, FT_KERNING_UNSCALED, &kern))
+    return 0;
+  if (kern.x)
+    return floor (kern.x * m->scale + 0.5);
+
+  return 0;
+}
+
+int
+hnj_measure_char_width (HnjMeasure *m, unsigned int c)
+{
+  unsigned int glyph;
+  FT_Fixed advance;
+
+  glyph = FT_Get_Char_Index (m->face, c);
+  if (FT_Get_Advance (m->face, glyph, FT_LOAD_NO_SCALE, &advance))
+    return 0;
+
+  return floor (advance * m->scale + 0.5);
+}
+
+unsigned int
+hnj_utf8_decode (const char *s, int *len)
+{
+  const unsigned char *u = (const unsigned char *) s;
+  unsigned int c;
+  int n;
+  int i;
+
+  if (u[0] < 0x80)
+    {
+      *len = 1;
+      return u[0];
+    }
+  else if ((u[0] & 0xe0) == 0xc0)
+    {
+      n = 2;
+      c = u[0] & 0x1f;
+    }
+  else if ((u[0] & 0xf0) == 0xe0)
+    {
+      n = 3;
+      c = u[0] & 0x0f;
+    }
+  else if ((u[0] & 0xf8) == 0xf0)
+    {
+      n = 4;
+      c = u[0] & 0x07;
+    }
+  else
+    {
+      *len = 1;
+      return 0xfffd;
+    }
+  for (i = 1; i < n; i++)
+    {
+      if ((u[i] & 0xc0) != 0x80)
+	{
+	  *len = 1;
+	  return 0xfffd;
+	}
+      c = (c << 6) | (u[i] & 0x3f);
+    }
+  *len = n;
+  return c;
+}
+
+/* Whether c extends the grapheme cluster before it: combining marks,
+   variation selectors, emoji modifiers and joiners. */
+static bool
+is_cluster_extend (unsigned int c)
+{
+  return (c >= 0x300 && c < 0x370) ||
+    (c >= 0x1ab0 && c < 0x1b00) ||
+    (c >= 0x1dc0 && c < 0x1e00) ||
+    (c >= 0x20d0 && c < 0x2100) ||
+    (c >= 0xfe00 && c < 0xfe10) ||
+    (c >= 0xfe20 && c < 0xfe30) ||
+    (c >= 0x1f3fb && c < 0x1f400) ||
+    c == 0x200c || c == 0x200d;
+}
+
+/* Joiners also take the character after them. */
+int
+hnj_next_cluster (const char *s, unsigned int *cps, int *n_cps)
+{
+  int size, len;
+  unsigned int c;
+
+  *n_cps = 0;
+  if (s[0] == 0)
+    return 0;
+  cps[(*n_cps)++] = hnj_utf8_decode (s, &size);
+  while (s[size] && *n_cps < HNJ_CLUSTER_MAX)
+    {
+      c = hnj_utf8_decode (s + size, &len);
+      if (!is_cluster_extend (c) && cps[*n_cps - 1] != 0x200d)
+	break;
+      cps[(*n_cps)++] = c;
+      size += len;
+    }
+  return size;
+}
+
+static unsigned int
+hash_cps (const unsigned int *cps, int n_cps)
+{
+  unsigned int h = 2166136261u;
+  int i;
+
+  for (i = 0; i < n_cps; i++)
+    h = (h ^ cps[i]) * 16777619u;
+  return h;
+}
+
+int
+hnj_measure_cluster_width (HnjMeasure *m, const unsigned int *cps, int n_cps)
+{
+  WidthEntry *e;
+  WidthEntry *old;
+  int old_size;
+  unsigned int mask;
+  unsigned int h;
+  int width;
+  int i;
+
+  if (m->n_widths * 2 >= m->widths_size)
+    {
+      old = m->widths;
+      old_size = m->widths_size;
+      m->widths = calloc (old_size ? old_size * 2 : 256, sizeof (WidthEntry));
+      if (m->widths == NULL)
+	{
+	  m->widths = old;
+	  return -1;
+	}
+      m->widths_size = old_size ? old_size * 2 : 256;
+      mask = m->widths_size - 1;
+      for (i = 0; i < old_size; i++)
+	if (old[i].n_cps)
+	  {
+	    for (h = hash_cps (old[i].cps, old[i].n_cps) & mask;
+		 m->widths[h].n_cps; h = (h + 1) & mask)
+	      ;
+	    m->widths[h] = old[i];
+	  }
+      free (old);
+    }
+
+  mask = m->widths_size - 1;
+  for (h = hash_cps (cps, n_cps) & mask; m->widths[h].n_cps;
+       h = (h + 1) & mask)
+    {
+      e = &m->widths[h];
+      if (e->n_cps == n_cps && !memcmp (e->cps, cps, n_cps * sizeof (*cps)))
+	return e->width;
+    }
+
+  width = 0;
+  for (i = 0; i < n_cps; i++)
+    width += hnj_measure_char_width (m, cps[i]);
+  e = &m->widths[h];
+  e->n_cps = n_cps;
+  memcpy (e->cps, cps, n_cps * sizeof (*cps));
+  e->width = width;
+  m->n_widths++;
+  return width;
+}
+
+/* Look up the kerning between c1 and c2 in the cache, adding it if it
+   isn't there. Returns 0, or -1 if out of memory. */
+static int
+kern_lookup (HnjMeasure *m, unsigned int c1, unsigned int c2, int *kern)
+{
+  KernEntry *e;
+  KernEntry *old;
+  int old_size;
+  unsigned int mask;
+  unsigned int h;
+  unsigned int key[2];
+  int i;
+
+  if (m->n_kerns * 2 >= m->kerns_size)
+    {
+      old = m->kerns;
+      old_size = m->kerns_size;
+      m->kerns = calloc (old_size ? old_size * 2 : 1024, sizeof (KernEntry));
+      if (m->kerns == NULL)
+	{
+	  m->kerns = old;
+	  return -1;
+	}
+      m->kerns_size = old_size ? old_size * 2 : 1024;
+      mask = m->kerns_size - 1;
+      for (i = 0; i < old_size; i++)
+	if (old[i].used)
+	  {
+	    key[0] = old[i].c1;
+	    key[1] = old[i].c2;
+	    for (h = hash_cps (key, 2) & mask; m->kerns[h].used;
+		 h = (h + 1) & mask)
+	      ;
+	    m->kerns[h] = old[i];
+	  }
+      free (old);
+    }
+
+  mask = m->kerns_size - 1;
+  key[0] = c1;
+  key[1] = c2;
+  for (h = hash_cps (key, 2) & mask; m->kerns[h].used; h = (h + 1) & mask)
+    {
+      e = &m->kerns[h];
+      if (e->c1 == c1 && e->c2 == c2)
+	{
+	  *kern = e->kern;
+	  return 0;
+	}
+    }
+
+  e = &m->kerns[h];
+  e->c1 = c1;
+  e->c2 = c2;
+  e->kern = measure_kern_pair (m, c1, c2);
+  e->used = true;
+  m->n_kerns++;
+  *kern = e->kern;
+  return 0;
+}
+
+int
+hnj_measure_kern (HnjMeasure *m, unsigned int c1, unsigned int c2)
+{
+  int kern;
+
+  if (kern_lookup (m, c1, c2, &kern))
+    return measure_kern_pair (m, c1, c2);
+  return kern;
+}
+
+/* Width of an ASCII word, from the direct tables, into *width. Every
+   ASCII character is a cluster of its own. Returns 0, or -1 if out of
+   memory. */
+static int
+ascii_word_width (HnjMeasure *m, const unsigned char *s, int l, int *width)
+{
+  const int *widths = m->ascii_widths;
+  int *kerns = m->ascii_kerns;
+  int *kern;
+  int i;
+
+  *width = 0;
+  for (i = 0; i < l - 1; i++)
+    {
+      kern = &kerns[s[i] << 7 | s[i + 1]];
+      if (*kern == KERN_UNKNOWN && kern_lookup (m, s[i], s[i + 1], kern))
+	{
+	  *kern = KERN_UNKNOWN;
+	  return -1;
+	}
+      *width += widths[s[i]] + *kern;
+    }
+  *width += widths[s[l - 1]];
+  return 0;
+}
+
+/* Replace v with its running sums. */
+static void
+prefix_sum (int *v, int n)
+{
+  int i = 0;
+
+#ifdef __SSE2__
+  __m128i carry = _mm_setzero_si128 ();
+  __m128i x;
+
+  for (; i + 4 <= n; i += 4)
+    {
+      x = _mm_loadu_si128 ((const __m128i *) (v + i));
+      x = _mm_add_epi32 (x, _mm_slli_si128 (x, 4));
+      x = _mm_add_epi32 (x, _mm_slli_si128 (x, 8));
+      x = _mm_add_epi32 (x, carry);
+      _mm_storeu_si128 ((__m128i *) (v + i), x);
+      carry = _mm_shuffle_epi32 (x, 0xff);
+    }
+#endif
+  for (; i < n; i++)
+    if (i > 0)
+      v[i] += v[i - 1];
+}
+
+/* Build the breaks of a paragraph, hyphenating the words for which
+   hyphenate is true, or all of them if hyphenate is NULL.
+
+   This goes in two passes. The first measures each word on its own,
+   into xs: the width of word i goes to xs[2 * i] and the space after
+   it to xs[2 * i + 1]. Words that aren't hyphenated and are all ASCII,
+   which is most of them, are measured straight from the direct
+   tables; the rest cluster by cluster, with their hyphen breaks
+   placed relative to the start of the word. The second pass turns xs
+   into running sums, which give the positions of the breaks. */
+static int
+measure_paragraph (HnjMeasure *m, HyphenDict *dict, const HnjHyphTrie *trie,
+		   const bool *hyphenate,
+		   char **words, int n_words, HnjBreak *breaks,
+		   int *is, int *js, int max_breaks)
+{
+  char *hbuf;
+  int hbuf_size;
+  int n_breaks;
+  int i, j;
+  int x;
+  int l;
+  int hyphwidth;
+  int spacewidth;
+  unsigned int cps[HNJ_CLUSTER_MAX], next_cps[HNJ_CLUSTER_MAX];
+  int n_cps, n_next_cps;
+  int size, next_size;
+  int n_chars;
+  int *xs;
+  int word_x;
+  int word_breaks;
+  int width, kern;
+  bool ascii;
+  long long t0, t;
+  long long hyph_ns;
+  bool hyph;
+
+  t0 = hnj_trace_begin ();
+  hyph_ns = 0;
+  if (measure_reserve (m, n_words))
+    return -1;
+  xs = m->xs;
+  hyphwidth = hnj_measure_char_width (m, '-');
+  spacewidth = hnj_measure_char_width (m, ' ');
+
+  hbuf = NULL;
+  hbuf_size = 0;
+  n_breaks = 0;
+
+  for (i = 0; i < n_words; i++)
+    {
+      ascii = true;
+      for (l = 0; words[i][l]; l++)
+	if (words[i][l] & 0x80)
+	  ascii = false;
+      hyph = (dict || trie) && (hyphenate == NULL || hyphenate[i]);
+      if (ascii && !hyph && l > 0)
+	{
+	  if (ascii_word_width (m, (const unsigned char *) words[i], l, &x))
+	    goto fail;
+	}
+      else
+	{
+	  if (hyph)
+	    {
+	      char **rep = NULL;
+	      int *pos = NULL;
+	      int *cut = NULL;
+
+	      if (l + 5 > hbuf_size)
+		{
+		  hbuf_size = l + 5;
+		  free (hbuf);
+		  hbuf = malloc (hbuf_size);
+		  if (hbuf == NULL)
+		    goto fail;
+		}
+	      t = t0 ? hnj_trace_begin () : 0;
+	      if (trie)
+		hnj_hyph_trie_hyphenate (trie, words[i], l, hbuf);
+	      else
+		hnj_hyphen_hyphenate2 (dict, words[i], l, hbuf, NULL, &rep,
+				       &pos, &cut);
+	      if (t)
+		hyph_ns += hnj_trace_begin () - t;
+	      if (rep)
+		{
+		  for (j = 0; j < l; j++)
+		    free (rep[j]);
+		  free (rep);
+		  free (pos);
+		  free (cut);
+		}
+	    }
+	  /* Measure cluster by cluster. A UTF-8 dictionary indexes its
+	     hyphens by character, others and tries by byte. */
+	  x = 0;
+	  j = 0;
+	  n_chars = 0;
+	  word_breaks = n_breaks;
+	  size = hnj_next_cluster (words[i], cps, &n_cps);
+	  while (size)
+	    {
+	      width = hnj_measure_cluster_width (m, cps, n_cps);
+	      if (width < 0)
+		goto fail;
+	      x += width;
+	      j += size;
+	      n_chars += n_cps;
+	      next_size = hnj_next_cluster (words[i] + j, next_cps,
+					    &n_next_cps);
+	      if (hyph && next_size &&
+		  hbuf[(dict && dict->utf8 ? n_chars : j) - 1] & 1)
+		{
+		  if (n_breaks == max_breaks)
+		    goto fail;
+		  breaks[n_breaks].x0 = x + hyphwidth;
+		  breaks[n_breaks].x1 = x;
+		  breaks[n_breaks].penalty = 1000000;
+		  breaks[n_breaks].flags = HNJ_JUST_FLAG_ISHYPHEN;
+		  is[n_breaks] = i;
+		  js[n_breaks] = j;
+		  n_breaks++;
+		}
+	      if (next_size)
+		{
+		  if (kern_lookup (m, cps[n_cps - 1], next_cps[0], &kern))
+		    goto fail;
+		  x += kern;
+		}
+	      memcpy (cps, next_cps, n_next_cps * sizeof (*cps));
+	      n_cps = n_next_cps;
+	      size = next_size;
+	    }
+	  /* The x0 of the breaks must stay in order (see just.h), so
+	     hyphens wider than the rest of their word are dropped. */
+	  while (n_breaks > word_breaks && breaks[n_breaks - 1].x0 > x)
+	    n_breaks--;
+	}
+      if (n_breaks == max_breaks)
+	goto fail;
+      xs[2 * i] = x;
+      xs[2 * i + 1] = spacewidth;
+      breaks[n_breaks].penalty = 0;
+      breaks[n_breaks].flags = HNJ_JUST_FLAG_ISSPACE;
+      is[n_breaks] = i;
+      js[n_breaks] = l;
+      n_breaks++;
+    }
+
+  prefix_sum (xs, 2 * n_words);
+  for (j = 0; j < n_breaks; j++)
+    {
+      i = is[j];
+      if (breaks[j].flags & HNJ_JUST_FLAG_ISSPACE)
+	{
+	  breaks[j].x0 = xs[2 * i];
+	  breaks[j].x1 = xs[2 * i + 1];
+	}
+      else
+	{
+	  word_x = i > 0 ? xs[2 * i - 1] : 0;
+	  breaks[j].x0 += word_x;
+	  breaks[j].x1 += word_x;
+	}
+    }
+
+  if (n_breaks > 0)
+    breaks[n_breaks - 1].flags = 0;
+  free (hbuf);
+  if (t0)
+    {
+      hnj_trace_add (&hyphenate_stage, hyph_ns);
+      hnj_trace_add (&metrics_stage, hnj_trace_begin () - t0 - hyph_ns);
+    }
+  return n_breaks;
+
+fail:
+  free (hbuf);
+  return -1;
+}
+
+int
+hnj_measure_paragraph (HnjMeasure *m, HyphenDict *dict,
+		       char **words, int n_words, HnjBreak *breaks,
+		       int *is, int *js, int max_breaks)
+{
+  if (m->trie)
+    dict = NULL;
+  return measure_paragraph (m, dict, m->trie, NULL, words, n_words, breaks,
+			    is, js, max_breaks);
+}
+
+/* Mark the words around the ends of the lines whose slack is over
+   tolerance: the last two words of the line and the first two of the
+   next, since hyphenating any of them may move text across the end.
+   The last line is never justified, so it never counts. Returns the
+   number of lines marked. */
+static int
+mark_loose_lines (const HnjBreak *breaks, const int *is, int n_words,
+		  const int *result, int n_result, int set_width,
+		  int tolerance, bool *hyphenate)
+{
+  int n_loose = 0;
+  int x = 0;
+  int slack;
+  int b;
+  int i, k;
+
+  for (k = 0; k < n_result - 1; k++)
+    {
+      b = result[k];
+      slack = set_width - (breaks[b].x0 - x);
+      x = breaks[b].x1;
+      if (!(breaks[b].flags & HNJ_JUST_FLAG_ISSPACE) ||
+	  (slack <= tolerance && slack >= -tolerance))
+	continue;
+      for (i = is[b] - 1; i <= is[b] + 2; i++)
+	if (i >= 0 && i < n_words)
+	  hyphenate[i] = true;
+      n_loose++;
+    }
+  return n_loose;
+}
+
+int
+hnj_measure_just (HnjMeasure *m, HyphenDict *dict,
+		  char **words, int n_words, const HnjParams *params,
+		  int tolerance, HnjBreak *breaks, int *is, int *js,
+		  int max_breaks, int *n_breaks, int *result,
+		  HnjLine *lines)
+{
+  bool *hyphenate;
+  int n_result;
+
+  *n_breaks = measure_paragraph (m, NULL, NULL, NULL, words, n_words, breaks,
+				 is, js, max_breaks);
+  if (*n_breaks <= 0)
+    return *n_breaks;
+  n_result = hnj_just_auto_lines (breaks, *n_breaks, params, NULL, result,
+				  lines);
+  if (m->trie)
+    dict = NULL;
+  if (n_result <= 0 || (dict == NULL && m->trie == NULL))
+    return n_result;
+
+  hyphenate = calloc (n_words, sizeof (bool));
+  if (hyphenate == NULL)
+    return -1;
+  if (mark_loose_lines (breaks, is, n_words, result, n_result,
+			params->set_width, tolerance, hyphenate))
+    {
+      *n_breaks = measure_paragraph (m, dict, m->trie, hyphenate, words,
+				     n_words, breaks, is, js, max_breaks);
+      if (*n_breaks > 0)
+	n_result = hnj_just_auto_lines (breaks, *n_breaks, params, NULL,
+					result, lines);
+      else
+	n_result = *n_breaks;
+    }
+  free (hyphenate);
+  return n_result;
+}
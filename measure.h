@@ -0,0 +1,116 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_MEASURE_H__
+#define __HNJ_MEASURE_H__
+
+/* Text measurement and break building, shared by psset and justd.
+   Not part of the library. */
+
+#include <stdbool.h>
+#include <hyphen.h>
+#include "just.h"
+#include "hyphtrie.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+typedef struct _HnjMeasure HnjMeasure;
+
+/* Longest grapheme cluster, in code points. Longer runs of combining
+   marks are split. */
+#define HNJ_CLUSTER_MAX 8
+
+/* Measure text set in face. scale converts font units to the units of
+   the breaks. The face must not be used by two threads at once, so
+   neither may a measure. */
+HnjMeasure *hnj_measure_new (FT_Face face, double scale);
+
+void hnj_measure_free (HnjMeasure *m);
+
+/* Hyphenate with trie rather than a libhyphen dictionary: while one
+   is set, it is used in place of the dict arguments below. The trie
+   is not copied, and may be shared between measures and threads. */
+void hnj_measure_set_hyph_trie (HnjMeasure *m, const HnjHyphTrie *trie);
+
+/* Decode the UTF-8 character at s, setting *len to its length in
+   bytes. Malformed input decodes as U+FFFD, one byte at a time. */
+unsigned int hnj_utf8_decode (const char *s, int *len);
+
+/* Find the grapheme cluster at s, storing its code points in cps,
+   which must have room for HNJ_CLUSTER_MAX. Returns its length in
+   bytes, 0 at the end of the string. */
+int hnj_next_cluster (const char *s, unsigned int *cps, int *n_cps);
+
+/* Advance width of a single character. */
+int hnj_measure_char_width (HnjMeasure *m, unsigned int c);
+
+/* Width of a cluster, without kerning inside it, or -1 if out of
+   memory. */
+int hnj_measure_cluster_width (HnjMeasure *m, const unsigned int *cps,
+			       int n_cps);
+
+/* Kerning between the last code point of a cluster and the first of
+   the next. If the cache can't grow, it is looked up in the font
+   every time. */
+int hnj_measure_kern (HnjMeasure *m, unsigned int c1, unsigned int c2);
+
+/* Build the potential breaks of a paragraph: one after each word, and
+   one at each hyphenation point dict (if non-NULL) finds. The word and
+   byte offset in it of each break go to is and js. The last break has
+   no flags. Returns the number of breaks, or -1 if there would be more
+   than max_breaks or on running out of memory. */
+int hnj_measure_paragraph (HnjMeasure *m, HyphenDict *dict,
+			   char **words, int n_words, HnjBreak *breaks,
+			   int *is, int *js, int max_breaks);
+
+/* Build the breaks of a paragraph and justify it with
+   hnj_just_auto_lines, hyphenating only where it helps. The paragraph
+   is first justified without hyphenation. If any line but the last
+   then has more than tolerance of slack (set_width minus its natural
+   width) either way, the words around the ends of those lines are
+   hyphenated and the paragraph justified again. Most paragraphs never
+   reach the hyphenator, and those that do get fewer breaks.
+
+   The breaks actually used are left in breaks, is and js, and their
+   number in *n_breaks. Returns the number of lines, or -1 if there
+   would be more than max_breaks breaks or out of memory. */
+int hnj_measure_just (HnjMeasure *m, HyphenDict *dict,
+		      char **words, int n_words, const HnjParams *params,
+		      int tolerance, HnjBreak *breaks, int *is, int *js,
+		      int max_breaks, int *n_breaks, int *result,
+		      HnjLine *lines);
+
+#endif /* __HNJ_MEASURE_H__ */
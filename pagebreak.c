@@ -0,0 +1,418 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Page breaking.
+
+   This is the same shortest path problem as justification, one level
+   up: lines take the place of words. The cost of a path through the
+   page breaks is found by a dynamic program that only looks back as
+   far as a page can hold, so it goes through the document in a
+   single pass.
+
+   A page break is settled once every path that may still be extended
+   goes through it. Those are the paths ending at the breaks a page
+   starting there could still end after (the window), plus the latest
+   break before the window, which an overfull page may start from. The
+   pages up to the last common break of those paths are committed and
+   forgotten, so memory stays bounded by the window plus the pages not
+   yet settled. */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "pagebreak.h"
+
+typedef struct _PageNode PageNode;
+
+#define HNJ_PAGE_INF LLONG_MAX
+
+/* Cost of a page that overflows because nothing fits on it. */
+#define HNJ_PAGE_OVERFULL (1LL << 48)
+
+/* A potential page break, after a line. dist is the least cost of
+   the pages up to this break, including its penalty, or HNJ_PAGE_INF
+   if the page can't break here. pred is the break before on such a
+   least cost path. y is the height of the document up to this break
+   and next_space the space above the next line, which is dropped if
+   the page breaks here. */
+struct _PageNode {
+  long long dist;
+  long long y;
+  int pred;
+  int next_space;
+  int penalty;
+  int stamp;
+  int count;
+};
+
+struct _HnjPageBuilder {
+  HnjPageParams params;
+  HnjPageCommitFunc commit;
+  void *closure;
+
+  /* nodes[i] is the break after line base + i. base is the last
+     committed break; -1 is the top of the document. */
+  PageNode *nodes;
+  int n_nodes;
+  int nodes_size;
+  int base;
+
+  /* The first break a page ending at the last line could start at,
+     and the latest break before that a page can start at, or
+     base - 1 if there is none. */
+  int first_active;
+  int last_finite;
+
+  int stamp;
+  int *chain;
+};
+
+static PageNode *
+node (HnjPageBuilder *pb, int i)
+{
+  return &pb->nodes[i - pb->base];
+}
+
+/* Height taken up by a page starting after break i and ending after
+   break j. */
+static long long
+page_used (HnjPageBuilder *pb, int i, int j)
+{
+  return node (pb, j)->y - node (pb, i)->y - node (pb, i)->next_space;
+}
+
+HnjPageBuilder *
+hnj_page_builder_new (const HnjPageParams *params, HnjPageCommitFunc commit,
+		      void *closure)
+{
+  HnjPageBuilder *pb;
+
+  pb = malloc (sizeof (HnjPageBuilder));
+  if (pb == NULL)
+    return NULL;
+  pb->params = *params;
+  if (pb->params.max_pending <= 0)
+    pb->params.max_pending = HNJ_PAGE_MAX_PENDING;
+  pb->commit = commit;
+  pb->closure = closure;
+  pb->nodes_size = 64;
+  pb->nodes = malloc (pb->nodes_size * sizeof (PageNode));
+  pb->chain = malloc (pb->nodes_size * sizeof (int));
+  if (pb->nodes == NULL || pb->chain == NULL)
+    {
+      hnj_page_builder_free (pb);
+      return NULL;
+    }
+  pb->n_nodes = 1;
+  pb->base = -1;
+  pb->nodes[0].dist = 0;
+  pb->nodes[0].y = 0;
+  pb->nodes[0].pred = -1;
+  pb->nodes[0].next_space = 0;
+  pb->nodes[0].penalty = 0;
+  pb->nodes[0].stamp = 0;
+  pb->first_active = -1;
+  pb->last_finite = -2;
+  pb->stamp = 0;
+  return pb;
+}
+
+void
+hnj_page_builder_free (HnjPageBuilder *pb)
+{
+  if (pb == NULL)
+    return;
+  free (pb->nodes);
+  free (pb->chain);
+  free (pb);
+}
+
+/* Commit the pages on the path to break k, and forget the breaks
+   before it. */
+static void
+commit_to (HnjPageBuilder *pb, int k)
+{
+  int n_chain;
+  int i;
+  int prev;
+  long long y;
+
+  n_chain = 0;
+  for (i = k; i != pb->base; i = node (pb, i)->pred)
+    pb->chain[n_chain++] = i;
+  prev = pb->base;
+  while (n_chain > 0)
+    {
+      i = pb->chain[--n_chain];
+      pb->commit (pb->closure, prev + 1, i - prev);
+      prev = i;
+    }
+
+  memmove (pb->nodes, node (pb, k),
+	   (pb->base + pb->n_nodes - k) * sizeof (PageNode));
+  pb->n_nodes -= k - pb->base;
+  pb->base = k;
+  if (pb->first_active < k)
+    pb->first_active = k;
+
+  /* Keep the heights small. */
+  y = pb->nodes[0].y;
+  for (i = 0; i < pb->n_nodes; i++)
+    pb->nodes[i].y -= y;
+}
+
+/* Mark the path to break i, counting the paths through each break. */
+static void
+mark_path (HnjPageBuilder *pb, int i)
+{
+  PageNode *n;
+
+  for (;; i = n->pred)
+    {
+      n = node (pb, i);
+      if (n->stamp != pb->stamp)
+	{
+	  n->stamp = pb->stamp;
+	  n->count = 0;
+	}
+      n->count++;
+      if (i == pb->base)
+	break;
+    }
+}
+
+/* The latest break i is on the path to, counting paths as for
+   mark_path. */
+static int
+common_break (HnjPageBuilder *pb, int i, int n_paths)
+{
+  while (i != pb->base && node (pb, i)->count != n_paths)
+    i = node (pb, i)->pred;
+  return i;
+}
+
+/* Find the best path to break j, from the breaks from first on, or
+   failing that, with an overfull page from break fallback. The last
+   page is free. */
+static void
+relax_line (HnjPageBuilder *pb, int j, int first, int fallback, int final)
+{
+  PageNode *n = node (pb, j);
+  int page_height = pb->params.page_height;
+  long long left;
+  long long d;
+  int i;
+
+  n->dist = HNJ_PAGE_INF;
+  if (n->penalty >= HNJ_PAGE_PENALTY_INF && !final)
+    return;
+  for (i = first; i < j; i++)
+    {
+      if (node (pb, i)->dist == HNJ_PAGE_INF)
+	continue;
+      left = final ? 0 : page_height - page_used (pb, i, j);
+      d = node (pb, i)->dist + left * left;
+      if (d < n->dist)
+	{
+	  n->dist = d;
+	  n->pred = i;
+	}
+    }
+  if (n->dist == HNJ_PAGE_INF)
+    {
+      /* Nothing fits: overflow the page. */
+      n->pred = fallback;
+      n->dist = node (pb, n->pred)->dist + HNJ_PAGE_OVERFULL;
+    }
+  if (!final)
+    n->dist += n->penalty;
+}
+
+/* Commit the pages every live path agrees on. If too many lines are
+   pending, commit the first page of the best path instead, and drop
+   the paths that disagree with it. */
+static void
+settle (HnjPageBuilder *pb)
+{
+  int last = pb->base + pb->n_nodes - 1;
+  int n_paths;
+  int best;
+  int first, fallback;
+  int k;
+  int i;
+
+  pb->stamp++;
+  n_paths = 0;
+  best = -2;
+  for (i = pb->first_active; i <= last; i++)
+    if (node (pb, i)->dist != HNJ_PAGE_INF)
+      {
+	mark_path (pb, i);
+	n_paths++;
+	if (best == -2 || node (pb, i)->dist < node (pb, best)->dist)
+	  best = i;
+      }
+  if (pb->last_finite >= pb->base)
+    {
+      mark_path (pb, pb->last_finite);
+      n_paths++;
+    }
+  if (n_paths == 0)
+    return;
+
+  k = common_break (pb, best == -2 ? pb->last_finite : best, n_paths);
+  if (k == pb->base && pb->n_nodes > pb->params.max_pending &&
+      best != -2 && best != pb->base)
+    {
+      /* Take the first page of the best path, and find the paths
+	 that don't start with it again. */
+      for (k = best; node (pb, k)->pred != pb->base; k = node (pb, k)->pred)
+	;
+      pb->stamp++;
+      node (pb, k)->stamp = pb->stamp;
+      for (i = k + 1; i <= last; i++)
+	{
+	  PageNode *n = node (pb, i);
+
+	  if (n->dist != HNJ_PAGE_INF &&
+	      (n->pred < k || node (pb, n->pred)->stamp != pb->stamp))
+	    {
+	      for (first = i; first > k; first--)
+		if (page_used (pb, first - 1, i) > pb->params.page_height)
+		  break;
+	      fallback = first - 1;
+	      while (fallback > k && node (pb, fallback)->dist == HNJ_PAGE_INF)
+		fallback--;
+	      relax_line (pb, i, first, fallback, 0);
+	    }
+	  if (n->dist != HNJ_PAGE_INF)
+	    n->stamp = pb->stamp;
+	}
+      if (pb->first_active < k)
+	pb->first_active = k;
+      pb->last_finite = k - 1;
+      for (i = pb->first_active - 1; i >= k; i--)
+	if (node (pb, i)->dist != HNJ_PAGE_INF)
+	  {
+	    pb->last_finite = i;
+	    break;
+	  }
+    }
+  if (k != pb->base)
+    commit_to (pb, k);
+}
+
+/* Add a line, and find the best path to the break after it. */
+static int
+add_line (HnjPageBuilder *pb, int height, int space_before, int penalty)
+{
+  PageNode *n;
+  int j;
+
+  if (pb->n_nodes == pb->nodes_size)
+    {
+      PageNode *new_nodes;
+      int *new_chain;
+
+      new_nodes = realloc (pb->nodes, pb->nodes_size * 2 * sizeof (PageNode));
+      if (new_nodes == NULL)
+	return -1;
+      pb->nodes = new_nodes;
+      new_chain = realloc (pb->chain, pb->nodes_size * 2 * sizeof (int));
+      if (new_chain == NULL)
+	return -1;
+      pb->chain = new_chain;
+      pb->nodes_size *= 2;
+    }
+
+  j = pb->base + pb->n_nodes;
+  node (pb, j - 1)->next_space = space_before;
+  n = &pb->nodes[pb->n_nodes++];
+  n->y = node (pb, j - 1)->y + space_before + height;
+  n->next_space = 0;
+  n->stamp = 0;
+  n->penalty = penalty;
+  n->pred = -1;
+
+  while (pb->first_active < j &&
+	 page_used (pb, pb->first_active, j) > pb->params.page_height)
+    {
+      if (node (pb, pb->first_active)->dist != HNJ_PAGE_INF)
+	pb->last_finite = pb->first_active;
+      pb->first_active++;
+    }
+
+  relax_line (pb, j, pb->first_active, pb->last_finite, 0);
+  return 0;
+}
+
+int
+hnj_page_builder_add_paragraph (HnjPageBuilder *pb, const int *heights,
+				const int *penalties, int n_lines,
+				int space_before)
+{
+  int penalty;
+  int i;
+
+  for (i = 0; i < n_lines; i++)
+    {
+      penalty = 0;
+      if (i < n_lines - 1)
+	{
+	  if (penalties)
+	    penalty = penalties[i];
+	  if (i == 0)
+	    penalty += pb->params.orphan_penalty;
+	  if (i == n_lines - 2)
+	    penalty += pb->params.widow_penalty;
+	}
+      if (add_line (pb, heights[i], i == 0 ? space_before : 0, penalty))
+	return -1;
+      settle (pb);
+    }
+  return 0;
+}
+
+int
+hnj_page_builder_finish (HnjPageBuilder *pb)
+{
+  int last = pb->base + pb->n_nodes - 1;
+
+  if (last == pb->base)
+    return 0;
+  relax_line (pb, last, pb->first_active, pb->last_finite, 1);
+  commit_to (pb, last);
+  return 0;
+}
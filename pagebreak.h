@@ -0,0 +1,101 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_PAGEBREAK_H__
+#define __HNJ_PAGEBREAK_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _HnjPageParams HnjPageParams;
+typedef struct _HnjPageBuilder HnjPageBuilder;
+
+/* Page breaking parameters. Heights are in any unit, as long as it's
+   the same for all of them.
+
+   A page costs the square of the height left empty at its bottom,
+   except for the last page, which is free. Breaking a page after the
+   first line of a paragraph (leaving an orphan) adds orphan_penalty,
+   and breaking before the last line (leaving a widow) adds
+   widow_penalty.
+
+   Pages are committed as soon as every way of breaking the rest of the
+   document agrees on them. max_pending bounds the number of lines
+   held back waiting for that; past it, the pages on the best path so
+   far are committed anyway. Zero means HNJ_PAGE_MAX_PENDING. */
+struct _HnjPageParams {
+  int page_height;
+  int widow_penalty;
+  int orphan_penalty;
+  int max_pending;
+};
+
+#define HNJ_PAGE_MAX_PENDING 4096
+
+/* A line penalty of HNJ_PAGE_PENALTY_INF or more means the page must
+   not be broken after the line. */
+#define HNJ_PAGE_PENALTY_INF 0x40000000
+
+/* Called for each page, in order, with the index of its first line
+   (counting from the first line added to the builder) and its number
+   of lines. */
+typedef void (*HnjPageCommitFunc) (void *closure, int first_line,
+				   int n_lines);
+
+HnjPageBuilder *hnj_page_builder_new (const HnjPageParams *params,
+				      HnjPageCommitFunc commit,
+				      void *closure);
+
+void hnj_page_builder_free (HnjPageBuilder *pb);
+
+/* Add the lines of a paragraph. heights has the height of each line,
+   and penalties (if non-NULL) the penalty for breaking the page after
+   each line but the last; the widow and orphan penalties are added
+   to these. space_before is the space above the paragraph, which is
+   dropped at the top of a page. May commit pages. Returns zero, or -1
+   if out of memory. */
+int hnj_page_builder_add_paragraph (HnjPageBuilder *pb, const int *heights,
+				    const int *penalties, int n_lines,
+				    int space_before);
+
+/* Commit the remaining pages. Returns zero, or -1 if out of memory. */
+int hnj_page_builder_finish (HnjPageBuilder *pb);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __HNJ_PAGEBREAK_H__ */
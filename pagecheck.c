@@ -0,0 +1,422 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+
+/* Differential check of the page builder against a reference.
+
+   Usage: pagecheck [-n documents] [-l max-lines] [-s seed] [-v]
+
+   Random documents are broken into pages by the streaming page
+   builder of pagebreak.c and by a plain dynamic program over the
+   whole document with the same recurrence. The cost of each result
+   is computed independently of both. With the default max_pending,
+   which the documents are too short to reach, the page builder must
+   match the reference exactly. With a small max_pending, which
+   commits pages before every path agrees on them, its result must
+   still be a valid set of pages costing no less than the reference,
+   and no more than max_pending lines plus a page may be held back.
+   Exits nonzero on any mismatch. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include "pagebreak.h"
+
+/* As in pagebreak.c. */
+#define PAGE_INF LLONG_MAX
+#define PAGE_OVERFULL (1LL << 48)
+
+typedef struct _Doc Doc;
+typedef struct _Mode Mode;
+typedef struct _Pages Pages;
+
+/* A document, as a list of lines. space[j] is the space above line j,
+   dropped at the top of a page, and penalty[j] the penalty for
+   breaking the page after it, widow and orphan penalties included;
+   given_penalty[j] is without them, as given to the page builder.
+   y[j + 1] is the height of the document up to the end of line j. */
+struct _Doc {
+  HnjPageParams params;
+  int n_lines;
+  int n_paragraphs;
+  int *para_start;
+  int *height;
+  int *space;
+  int *penalty;
+  int *given_penalty;
+  long long *y;
+};
+
+struct _Mode {
+  const char *name;
+  int max_pending; /* 0 for the default */
+  double time;
+  long long cost;
+  int n_mismatches;
+};
+
+/* The pages committed by the page builder. */
+struct _Pages {
+  int n_pages;
+  int *end;
+  int n_committed;
+  int n_added;
+  int max_held;
+  int valid;
+};
+
+#define MODE(name, max_pending) { name, max_pending, 0, 0, 0 }
+
+static Mode modes[] = {
+  MODE ("stream", 0),
+  MODE ("backstop", 1),
+  MODE ("backstop-8", 8),
+  MODE ("backstop-64", 64)
+};
+
+#define N_MODES (sizeof (modes) / sizeof (modes[0]))
+
+static double
+get_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Height taken up by a page starting after line i (-1 for the top of
+   the document) and ending after line j. */
+static long long
+page_used (const Doc *doc, int i, int j)
+{
+  return doc->y[j + 1] - doc->y[i + 1] - doc->space[i + 1];
+}
+
+/* The cost of a page from after line i to after line j, without the
+   penalty of the break. */
+static long long
+page_cost (const Doc *doc, int i, int j)
+{
+  long long left = doc->params.page_height - page_used (doc, i, j);
+
+  if (left < 0)
+    return PAGE_OVERFULL;
+  if (j == doc->n_lines - 1)
+    return 0;
+  return left * left;
+}
+
+/* The recurrence of pagebreak.c over the whole document at once:
+   the best path to the break after line j comes from the breaks a
+   page ending at j fits after, or failing that, with an overfull
+   page from the latest break before those with a path to it. dist
+   has n_lines + 1 entries, dist[0] being the top of the document.
+   Returns the cost of the best path. */
+static long long
+reference_pages (const Doc *doc, long long *dist)
+{
+  int n_lines = doc->n_lines;
+  int first;
+  int final;
+  long long d;
+  int i, j;
+
+  dist[0] = 0;
+  first = -1;
+  for (j = 0; j < n_lines; j++)
+    {
+      final = j == n_lines - 1;
+      while (first < j && page_used (doc, first, j) >
+	     doc->params.page_height)
+	first++;
+      dist[j + 1] = PAGE_INF;
+      if (doc->penalty[j] >= HNJ_PAGE_PENALTY_INF && !final)
+	continue;
+      for (i = first; i < j; i++)
+	if (dist[i + 1] != PAGE_INF)
+	  {
+	    d = dist[i + 1] + page_cost (doc, i, j);
+	    if (d < dist[j + 1])
+	      dist[j + 1] = d;
+	  }
+      if (dist[j + 1] == PAGE_INF)
+	{
+	  for (i = first - 1; dist[i + 1] == PAGE_INF; i--)
+	    ;
+	  dist[j + 1] = dist[i + 1] + PAGE_OVERFULL;
+	}
+      if (!final)
+	dist[j + 1] += doc->penalty[j];
+    }
+  return dist[n_lines];
+}
+
+static void
+commit_page (void *closure, int first_line, int n_lines)
+{
+  Pages *pages = closure;
+
+  if (n_lines < 1 || first_line != pages->n_committed)
+    pages->valid = 0;
+  pages->end[pages->n_pages++] = first_line + n_lines - 1;
+  pages->n_committed = first_line + n_lines;
+}
+
+/* The cost of the pages, or -1 if they don't cover the document or
+   break where they mustn't. */
+static long long
+pages_cost (const Doc *doc, const Pages *pages)
+{
+  long long cost = 0;
+  int prev = -1;
+  int i, j;
+
+  if (!pages->valid || pages->n_committed != doc->n_lines)
+    return -1;
+  for (i = 0; i < pages->n_pages; i++)
+    {
+      j = pages->end[i];
+      if (j != doc->n_lines - 1)
+	{
+	  if (doc->penalty[j] >= HNJ_PAGE_PENALTY_INF)
+	    return -1;
+	  cost += doc->penalty[j];
+	}
+      cost += page_cost (doc, prev, j);
+      prev = j;
+    }
+  return cost;
+}
+
+/* Break doc into pages with the page builder, holding back no more
+   than max_pending lines if it is not 0. */
+static long long
+stream_pages (const Doc *doc, int max_pending, Pages *pages)
+{
+  HnjPageParams params = doc->params;
+  HnjPageBuilder *pb;
+  int start, n;
+  int i;
+
+  params.max_pending = max_pending;
+  pages->n_pages = 0;
+  pages->n_committed = 0;
+  pages->n_added = 0;
+  pages->max_held = 0;
+  pages->valid = 1;
+  pb = hnj_page_builder_new (&params, commit_page, pages);
+  if (pb == NULL)
+    return -1;
+  for (i = 0; i < doc->n_paragraphs; i++)
+    {
+      start = doc->para_start[i];
+      n = doc->para_start[i + 1] - start;
+      if (hnj_page_builder_add_paragraph (pb, doc->height + start,
+					  doc->given_penalty + start, n,
+					  doc->space[start]))
+	{
+	  hnj_page_builder_free (pb);
+	  return -1;
+	}
+      pages->n_added += n;
+      if (pages->n_added - pages->n_committed > pages->max_held)
+	pages->max_held = pages->n_added - pages->n_committed;
+    }
+  hnj_page_builder_finish (pb);
+  hnj_page_builder_free (pb);
+  return pages_cost (doc, pages);
+}
+
+/* Make up a document. */
+static void
+gen_doc (Doc *doc, int max_lines)
+{
+  int n_lines = 1 + rand () % max_lines;
+  int line_height = 10 + rand () % 5;
+  int n;
+  int i, j;
+
+  doc->params.page_height = line_height * (1 + rand () % 60);
+  doc->params.widow_penalty = rand () % 2 ? 0 : rand () % 10000;
+  doc->params.orphan_penalty = rand () % 2 ? 0 : rand () % 10000;
+  doc->params.max_pending = 0;
+
+  doc->n_lines = n_lines;
+  doc->n_paragraphs = 0;
+  for (i = 0; i < n_lines; i += n)
+    {
+      n = 1 + rand () % 20;
+      if (n > n_lines - i)
+	n = n_lines - i;
+      doc->para_start[doc->n_paragraphs++] = i;
+      for (j = i; j < i + n; j++)
+	{
+	  doc->height[j] = line_height;
+	  if (rand () % 50 == 0)
+	    doc->height[j] += rand () % (3 * line_height);
+	  if (rand () % 500 == 0)
+	    doc->height[j] += doc->params.page_height;
+	  doc->space[j] = j == i && rand () % 2 ? rand () % line_height : 0;
+	  doc->given_penalty[j] = 0;
+	  if (rand () % 20 == 0)
+	    doc->given_penalty[j] = rand () % 1000;
+	  if (rand () % 100 == 0)
+	    doc->given_penalty[j] = HNJ_PAGE_PENALTY_INF;
+	  doc->penalty[j] = 0;
+	  if (j < i + n - 1)
+	    {
+	      doc->penalty[j] = doc->given_penalty[j];
+	      if (j == i)
+		doc->penalty[j] += doc->params.orphan_penalty;
+	      if (j == i + n - 2)
+		doc->penalty[j] += doc->params.widow_penalty;
+	    }
+	}
+    }
+  doc->para_start[doc->n_paragraphs] = n_lines;
+  doc->space[n_lines] = 0;
+
+  doc->y[0] = 0;
+  for (j = 0; j < n_lines; j++)
+    doc->y[j + 1] = doc->y[j] + doc->space[j] + doc->height[j];
+}
+
+int
+main (int argc, char **argv)
+{
+  int n_docs = 300;
+  int max_lines = 2000;
+  unsigned int seed = 1;
+  int verbose = 0;
+  Doc doc;
+  Pages pages;
+  long long *dist;
+  long long ref_cost, cost;
+  int max_page_lines;
+  int n_failed = 0;
+  int bad;
+  double t;
+  int i;
+  unsigned int m;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (!strcmp (argv[i], "-n") && i + 1 < argc)
+	n_docs = atoi (argv[++i]);
+      else if (!strcmp (argv[i], "-l") && i + 1 < argc)
+	max_lines = atoi (argv[++i]);
+      else if (!strcmp (argv[i], "-s") && i + 1 < argc)
+	seed = strtoul (argv[++i], NULL, 0);
+      else if (!strcmp (argv[i], "-v"))
+	verbose = 1;
+      else
+	{
+	  fprintf (stderr, "usage: pagecheck [-n documents] [-l max-lines] "
+		   "[-s seed] [-v]\n");
+	  return 1;
+	}
+    }
+  if (max_lines < 1)
+    max_lines = 1;
+  if (max_lines >= HNJ_PAGE_MAX_PENDING)
+    max_lines = HNJ_PAGE_MAX_PENDING - 1;
+
+  doc.para_start = malloc ((max_lines + 1) * sizeof (int));
+  doc.height = malloc (max_lines * sizeof (int));
+  doc.space = malloc ((max_lines + 1) * sizeof (int));
+  doc.penalty = malloc (max_lines * sizeof (int));
+  doc.y = malloc ((max_lines + 1) * sizeof (long long));
+  doc.given_penalty = malloc (max_lines * sizeof (int));
+  dist = malloc ((max_lines + 1) * sizeof (long long));
+  pages.end = malloc (max_lines * sizeof (int));
+
+  srand (seed);
+  for (i = 0; i < n_docs; i++)
+    {
+      gen_doc (&doc, max_lines);
+      ref_cost = reference_pages (&doc, dist);
+      for (m = 0; m < N_MODES; m++)
+	{
+	  t = get_time ();
+	  cost = stream_pages (&doc, modes[m].max_pending, &pages);
+	  modes[m].time += get_time () - t;
+	  if (cost >= 0)
+	    modes[m].cost += cost;
+	  if (modes[m].max_pending == 0)
+	    bad = cost != ref_cost;
+	  else
+	    {
+	      /* Lines are at least 10 high, so a page holds no more
+		 than this many. */
+	      max_page_lines = doc.params.page_height / 10 + 1;
+	      bad = cost < ref_cost ||
+		pages.max_held > modes[m].max_pending + max_page_lines;
+	    }
+	  if (bad)
+	    {
+	      modes[m].n_mismatches++;
+	      n_failed++;
+	      fprintf (stderr, "document %d (%d lines): %s cost %lld, "
+		       "reference %lld, %d lines held back\n", i, doc.n_lines,
+		       modes[m].name, cost, ref_cost, pages.max_held);
+	    }
+	  else if (verbose)
+	    fprintf (stderr, "document %d (%d lines): %s cost %lld, "
+		     "reference %lld, %d lines held back\n", i, doc.n_lines,
+		     modes[m].name, cost, ref_cost, pages.max_held);
+	}
+    }
+
+  printf ("%d documents of up to %d lines, seed %u\n", n_docs, max_lines,
+	  seed);
+  printf ("%-12s %12s %20s %10s\n", "mode", "time (ms)", "total cost",
+	  "mismatch");
+  for (m = 0; m < N_MODES; m++)
+    printf ("%-12s %12.2f %20lld %10d\n", modes[m].name,
+	    modes[m].time * 1e3, modes[m].cost, modes[m].n_mismatches);
+
+  free (doc.para_start);
+  free (doc.height);
+  free (doc.space);
+  free (doc.penalty);
+  free (doc.y);
+  free (doc.given_penalty);
+  free (dist);
+  free (pages.end);
+  return n_failed != 0;
+}
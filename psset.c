@@ -44,19 +44,26 @@
 #include <hyphen.h>
 #include "hsjust.h"
 #include "hqjust.h"
+#include "hyphtrie.h"
+#include "pagebreak.h"
+#include "measure.h"
+#include "trace.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include FT_ADVANCES_H
 
 #include <cairo.h>
 #include <cairo-ft.h>
 #include <cairo-ps.h>
 
 typedef struct _PSOContext PSOContext;
-
+typedef struct _PSOLine PSOLine;
 #define SCALE 50
 
+HNJ_TRACE_STAGE (paragraph_stage, "paragraph");
+HNJ_TRACE_STAGE (break_stage, "break_lines");
+HNJ_TRACE_STAGE (draw_stage, "draw");
+
 /* PostScript output context */
 struct _PSOContext {
   cairo_t *cr;
@@ -71,48 +78,33 @@ struct _PSOContext {
 
   double y;
   double space;
-};
-
-/* get xamt of kern pair */
-static int
-get_kern_pair (PSOContext *pso, int c1, int c2)
-{
-  unsigned int glyph1, glyph2;
-  FT_Vector kern;
   double scale;
 
-  scale = pso->fontsize * 0.001 * SCALE;
+  HnjMeasure *measure;
 
-  glyph1 = FT_Get_Char_Index (pso->face, c1);
-  glyph2 = FT_Get_Char_Index (pso->face, c2);
-  if (FT_Get_Kerning (pso->face, glyph1, glyph2, FT_KERNING_UNSCALED, &kern))
-    return 0;
-  if (kern.x)
-    return floor (kern.x * scale + 0.5);
-
-  return 0;
-}
+  /* Lines waiting for the page builder to settle their page.
+     lines[0] is line first_line of the document. */
+  HnjPageBuilder *pages;
+  PSOLine *lines;
+  int n_lines;
+  int lines_size;
+  int first_line;
+  int n_paragraphs;
+};
 
-static int
-get_width (PSOContext *pso, int c)
-{
-  unsigned int glyph;
-  FT_Fixed advance;
+/* A line set but not yet shown. */
+struct _PSOLine {
+  char **words;
+  int n_words;
+  double space;
   double scale;
-
-  scale = pso->fontsize * 0.001 * SCALE;
-
-  glyph = FT_Get_Char_Index (pso->face, c);
-  if (FT_Get_Advance (pso->face, glyph, FT_LOAD_NO_SCALE, &advance))
-    return 0;
-
-  return floor (advance * scale + 0.5);
-
-}
+  bool para_start;
+};
 
 static void
 pso_begin_page (PSOContext *pso)
 {
+  pso->y = floor (pso->top + .66 * pso->fontsize);
 }
 
 static void
@@ -121,17 +113,19 @@ pso_end_page (PSOContext *pso)
   cairo_surface_show_page (pso->ps);
 }
 
+/* Glyphs on the line are scaled horizontally by scale, for font
+   expansion. */
 static void
-pso_begin_line (PSOContext *pso, double space)
+pso_begin_line (PSOContext *pso, double space, double scale)
 {
-  if (pso->y > pso->bot + 0.34 * pso->fontsize)
-    {
-      pso_end_page (pso);
-      pso->y = floor (pso->top + .66 * pso->fontsize);
-      pso_begin_page (pso);
-    }
+  cairo_matrix_t font_matrix;
+
   cairo_move_to (pso->cr, pso->left, pso->y);
   pso->space = space;
+  pso->scale = scale;
+  cairo_matrix_init_scale (&font_matrix, pso->fontsize * scale,
+			   pso->fontsize);
+  cairo_set_font_matrix (pso->cr, &font_matrix);
 }
 
 static void
@@ -150,17 +144,27 @@ pso_blank_line (PSOContext *pso)
 static void
 pso_show_word (PSOContext *pso, const char *word, bool space)
 {
-  char ch[2] = { '\0' };
-  int i;
+  char cluster[HNJ_CLUSTER_MAX * 4 + 1];
+  unsigned int cps[HNJ_CLUSTER_MAX], next_cps[HNJ_CLUSTER_MAX];
+  int n_cps, n_next_cps;
+  int size, next_size;
   int kern;
 
-  for (i = 0; word[i]; i++)
+  size = hnj_next_cluster (word, cps, &n_cps);
+  while (size)
     {
-      ch[0] = word[i];
-      cairo_show_text (pso->cr, ch);
-      kern = get_kern_pair (pso, word[i], word[i + 1]);
+      memcpy (cluster, word, size);
+      cluster[size] = '\0';
+      cairo_show_text (pso->cr, cluster);
+      word += size;
+      next_size = hnj_next_cluster (word, next_cps, &n_next_cps);
+      kern = hnj_measure_kern (pso->measure, cps[n_cps - 1],
+			       next_size ? next_cps[0] : 0);
       if (kern)
-        cairo_rel_move_to (pso->cr, kern * (1.0 / SCALE), 0);
+        cairo_rel_move_to (pso->cr, kern * pso->scale * (1.0 / SCALE), 0);
+      memcpy (cps, next_cps, n_next_cps * sizeof (*cps));
+      n_cps = n_next_cps;
+      size = next_size;
     }
 
   if (space)
@@ -178,134 +182,165 @@ strdup_from_buf (const char *buf, int size)
   return new;
 }
 
+/* Start a new line, to be shown once its page is settled. */
+static PSOLine *
+pso_new_line (PSOContext *pso, double space, double scale, bool para_start)
+{
+  PSOLine *line;
+
+  if (pso->n_lines == pso->lines_size)
+    {
+      pso->lines_size = pso->lines_size ? pso->lines_size * 2 : 256;
+      pso->lines = realloc (pso->lines, pso->lines_size * sizeof (PSOLine));
+    }
+  line = &pso->lines[pso->n_lines++];
+  line->words = NULL;
+  line->n_words = 0;
+  line->space = space;
+  line->scale = scale;
+  line->para_start = para_start;
+  return line;
+}
+
+static void
+pso_line_add_word (PSOLine *line, const char *word, int size)
+{
+  line->words = realloc (line->words, (line->n_words + 1) * sizeof (char *));
+  line->words[line->n_words++] = strdup_from_buf (word, size);
+}
+
+/* Page builder callback: show a page of lines. */
+static void
+pso_commit_page (void *closure, int first_line, int n_lines)
+{
+  PSOContext *pso = closure;
+  PSOLine *line;
+  long long t0;
+  int i, j;
+
+  t0 = hnj_trace_begin ();
+  pso_begin_page (pso);
+  for (i = 0; i < n_lines; i++)
+    {
+      line = &pso->lines[first_line - pso->first_line + i];
+      if (i > 0 && line->para_start)
+	pso_blank_line (pso);
+      pso_begin_line (pso, line->space, line->scale);
+      for (j = 0; j < line->n_words; j++)
+	{
+	  pso_show_word (pso, line->words[j], j < line->n_words - 1);
+	  free (line->words[j]);
+	}
+      free (line->words);
+      pso_end_line (pso);
+    }
+  pso_end_page (pso);
+  hnj_trace_end (&draw_stage, t0, "n_lines", n_lines);
+
+  pso->n_lines -= first_line + n_lines - pso->first_line;
+  memmove (pso->lines, pso->lines + first_line + n_lines - pso->first_line,
+	   pso->n_lines * sizeof (PSOLine));
+  pso->first_line = first_line + n_lines;
+}
+
 static void
 hnj (char **words, int n_words, HyphenDict *dict, HnjParams *params,
      PSOContext *pso)
 {
-  char hbuf[256];
   HnjBreak breaks[16384];
   int result[16384];
+  HnjLine lines[16384];
   int is[16384], js[16384];
   int n_breaks;
   int i, j;
-  int x;
-  int l;
   int n_actual_breaks;
   int line_num;
   int break_num;
-  int hyphwidth;
   int spacewidth;
-  char new_word[256];
   int word_offset;
-  int n_space;
-  int width;
   double space;
-
-  hyphwidth = get_width (pso, '-');
-  spacewidth = get_width (pso, ' ');
-
-  n_breaks = 0;
-  x = 0;
-
-  for (i = 0; i < n_words; i++)
+  PSOLine *line;
+  int heights[16384];
+  int space_before;
+  long long t_para, t0;
+
+  t_para = hnj_trace_begin ();
+  spacewidth = hnj_measure_char_width (pso->measure, ' ');
+
+  /* Lines with more than two spaces' worth of slack get the words
+     around their ends hyphenated. */
+  t0 = hnj_trace_begin ();
+  n_actual_breaks = hnj_measure_just (pso->measure, dict, words, n_words,
+				      params, 2 * spacewidth, breaks, is, js,
+				      16384, &n_breaks, result, lines);
+  hnj_trace_end (&break_stage, t0, "n_breaks", n_breaks);
+  if (n_actual_breaks <= 0)
     {
-      l = strlen (words[i]);
-      if (dict)
-        {
-          char **rep = NULL;
-          int *pos = NULL;
-          int *cut = NULL;
-          hnj_hyphen_hyphenate2 (dict, words[i], l, hbuf, NULL, &rep, &pos, &cut);
-        }
-      for (j = 0; j < l; j++)
-	{
-	  x += get_width (pso, words[i][j]);
-	  if (dict && hbuf[j] & 1)
-	    {
-	      breaks[n_breaks].x0 = x + hyphwidth;
-	      breaks[n_breaks].x1 = x;
-	      breaks[n_breaks].penalty = 1000000;
-	      breaks[n_breaks].flags = HNJ_JUST_FLAG_ISHYPHEN;
-	      is[n_breaks] = i;
-	      js[n_breaks] = j + 1;
-	      n_breaks++;
-	    }
-	  if (words[i][j + 1])
-	    {
-	      x += get_kern_pair (pso, words[i][j], words[i][j + 1]);
-	    }
-	}
-      breaks[n_breaks].x0 = x;
-      x += spacewidth;
-      breaks[n_breaks].x1 = x;
-      breaks[n_breaks].penalty = 0;
-      breaks[n_breaks].flags = HNJ_JUST_FLAG_ISSPACE;
-      is[n_breaks] = i;
-      js[n_breaks] = l;
-      n_breaks++;
+      hnj_trace_end (&paragraph_stage, t_para, "n_words", n_words);
+      return;
     }
-  breaks[n_breaks - 1].flags = 0;
-  n_actual_breaks = hnj_hq_just (breaks, n_breaks,
-				 params, result);
 
   word_offset = 0;
-  x = 0;
   i = 0;
   /* Now print the paragraph with the breaks present. */
   for (line_num = 0; line_num < n_actual_breaks; line_num++)
     {
       break_num = result[line_num];
 
-      /* Calculate the width of the non-space section of the line */
-
-      n_space = is[break_num] - i;
-
-      width = (breaks[break_num].x0 - x) - n_space * spacewidth;
-#ifdef VERBOSE
-      fprintf (stderr, "%% x0 = %d, x1 = %d%s\n", breaks[break_num].x0, breaks[break_num].x1, breaks[break_num].flags & HNJ_JUST_FLAG_ISHYPHEN ? " -" : "");
-#endif
-      if (n_space && ((breaks[break_num].flags & (HNJ_JUST_FLAG_ISHYPHEN |
-						 HNJ_JUST_FLAG_ISSPACE)) ||
-		      width + n_space * spacewidth > params->set_width))
-	space = ((1.0 / SCALE) * (params->set_width - width)) / n_space;
-      else
-	space = spacewidth * (1.0 / SCALE);
+      /* Every space on the line takes its share of the stretch; the
+	 glyphs take the rest by scaling. */
+      space = spacewidth * (1.0 / SCALE);
+      if (lines[line_num].n_spaces)
+	space += ((1.0 / SCALE) * lines[line_num].stretch) /
+	  lines[line_num].n_spaces;
 
 #ifdef VERBOSE
-      fprintf (stderr, "%% width=%d, n_space = %d\n", width, n_space);
+      fprintf (stderr, "%% width=%d, n_spaces = %d, stretch = %d, "
+	       "expand = %d%s\n",
+	       lines[line_num].width, lines[line_num].n_spaces,
+	       lines[line_num].stretch, lines[line_num].expand,
+	       breaks[break_num].flags & HNJ_JUST_FLAG_ISHYPHEN ? " -" : "");
 #endif
-      pso_begin_line (pso, space);
+      line = pso_new_line (pso, space, 1 + lines[line_num].expand / 65536.0,
+			   line_num == 0);
+      heights[line_num] = floor (pso->linespace * SCALE + 0.5);
 
       for (; i < is[break_num]; i++)
 	{
-	  pso_show_word (pso, words[i] + word_offset, true);
+	  pso_line_add_word (line, words[i] + word_offset,
+			     strlen (words[i] + word_offset));
 	  word_offset = 0;
 	}
       if (breaks[break_num].flags & HNJ_JUST_FLAG_ISSPACE)
 	{
-	  pso_show_word (pso, words[i] + word_offset, false);
+	  pso_line_add_word (line, words[i] + word_offset,
+			     strlen (words[i] + word_offset));
 	  i++;
-	  pso_end_line (pso);
 	  word_offset = 0;
 	}
       else if (breaks[break_num].flags & HNJ_JUST_FLAG_ISHYPHEN)
 	{
 	  j = js[break_num];
-	  memcpy (new_word, words[i] + word_offset, j - word_offset);
-	  new_word[j - word_offset] = '-';
-	  new_word[j + 1 - word_offset] = 0;
-	  pso_show_word (pso, new_word, true);
-	  pso_end_line (pso);
+	  pso_line_add_word (line, words[i] + word_offset, j - word_offset + 1);
+	  line->words[line->n_words - 1][j - word_offset] = '-';
 	  word_offset = j;
 	}
       else
 	{
-	  pso_show_word (pso, words[i] + word_offset, false);
-	  pso_end_line (pso);
-	  pso_blank_line (pso);
+	  pso_line_add_word (line, words[i] + word_offset,
+			     strlen (words[i] + word_offset));
 	}
-      x = breaks[break_num].x1;
    }
+
+  hnj_trace_end (&paragraph_stage, t_para, "n_words", n_words);
+
+  /* Paragraphs are separated by a blank line. Adding the paragraph
+     may settle pages, which are drawn (and timed) right away. */
+  space_before = 0;
+  if (pso->n_paragraphs++ > 0)
+    space_before = floor (pso->linespace * SCALE + 0.5);
+  hnj_page_builder_add_paragraph (pso->pages, heights, NULL,
+				  n_actual_breaks, space_before);
 }
 
 static cairo_status_t
@@ -329,12 +364,17 @@ main (int argc, char **argv)
   PSOContext pso;
 
   HyphenDict *dict;
+  HnjHyphTrie *trie;
   char buf[256];
   HnjParams params;
+  HnjPageParams page_params;
   char *words[2048];
   int i;
   int beg_word;
   int word_idx;
+  bool stats = false;
+  bool expand = false;
+  long long t0;
 
   pso.fontsize = 12;
   pso.linespace = 14;
@@ -343,7 +383,35 @@ main (int argc, char **argv)
   pso.right = 72 + 216;
   pso.top = 72;
   pso.bot = 720;
-  pso.y = floor (pso.top + .66 * pso.fontsize);
+  pso.lines = NULL;
+  pso.n_lines = 0;
+  pso.lines_size = 0;
+  pso.first_line = 0;
+  pso.n_paragraphs = 0;
+
+  for (i = 1; i < argc; i++)
+    {
+      if (!strcmp (argv[i], "--stats"))
+	stats = true;
+      else if (!strcmp (argv[i], "--expand"))
+	expand = true;
+      else if (!strcmp (argv[i], "--trace") && i + 1 < argc)
+	{
+	  if (hnj_trace_open (argv[++i]))
+	    {
+	      fprintf (stderr, "psset: can't open %s\n", argv[i]);
+	      return 1;
+	    }
+	}
+      else
+	{
+	  fprintf (stderr, "usage: psset [--stats] [--expand] [--trace file] "
+		   "< text > ps\n");
+	  return 1;
+	}
+    }
+  if (stats)
+    hnj_trace_enable (1);
 
   if (FT_Init_FreeType (&library))
     return 1;
@@ -353,20 +421,45 @@ main (int argc, char **argv)
     return 1;
   if (FT_Attach_File (pso.face, afm_fn))
     return 1;
+  pso.measure = hnj_measure_new (pso.face, pso.fontsize * 0.001 * SCALE);
 
   pso.ps = cairo_ps_surface_create_for_stream (write_from_cairo, stdout, 595, 842);
   pso.cr = cairo_create (pso.ps);
 
   params.set_width = floor ((pso.right - pso.left) * SCALE + 0.5);
   params.max_neg_space = 128;
-  dict = hnj_hyphen_load ("hyphen.mashed");
+  params.tab_width = 0;
+  /* With --expand, let the glyphs stretch or shrink by up to 2%
+     (5/256). */
+  params.max_expand = expand ? 5 : 0;
+  params.max_shrink = expand ? 5 : 0;
+  /* The compiled patterns are mapped rather than parsed, so they are
+     preferred when present. */
+  trie = hnj_hyph_trie_open ("hyphen.trie");
+  if (trie)
+    {
+      hnj_measure_set_hyph_trie (pso.measure, trie);
+      dict = NULL;
+    }
+  else
+    dict = hnj_hyphen_load ("hyphen.mashed");
+
+  /* A line fits on the page as long as its baseline is above
+     bot + 0.34 * fontsize. Widows and orphans cost about as much as
+     leaving two lines empty. */
+  page_params.page_height = floor ((pso.bot + 0.34 * pso.fontsize -
+				    floor (pso.top + .66 * pso.fontsize) +
+				    pso.linespace) * SCALE + 0.5);
+  page_params.widow_penalty = 4 * (pso.linespace * SCALE) *
+    (pso.linespace * SCALE);
+  page_params.orphan_penalty = page_params.widow_penalty;
+  page_params.max_pending = 0;
+  pso.pages = hnj_page_builder_new (&page_params, pso_commit_page, &pso);
 
   cairo_font_face_t *cr_face = cairo_ft_font_face_create_for_ft_face (pso.face, 0);
   cairo_set_font_face (pso.cr, cr_face);
   cairo_set_font_size (pso.cr, pso.fontsize);
 
-  pso_begin_page (&pso);
-
   word_idx = 0;
   /* Parse a paragraph into the words data structures. */
   while (fgets (buf, sizeof(buf), stdin))
@@ -381,7 +474,7 @@ main (int argc, char **argv)
       beg_word = 0;
       for (i = 0; i < sizeof(buf) && buf[i] != '\n'; i++)
 	{
-	  if (isspace (buf[i]))
+	  if (isspace ((unsigned char) buf[i]))
 	    {
 	      if (i != beg_word)
 		words[word_idx++] = strdup_from_buf (buf + beg_word,
@@ -396,11 +489,21 @@ main (int argc, char **argv)
   if (word_idx > 0)
     hnj (words, word_idx, dict, &params, &pso);
 
-  pso_end_page (&pso);
+  hnj_page_builder_finish (pso.pages);
+  hnj_page_builder_free (pso.pages);
+  free (pso.lines);
+  hnj_measure_free (pso.measure);
+  hnj_hyph_trie_close (trie);
 
+  t0 = hnj_trace_begin ();
   cairo_destroy (pso.cr);
   cairo_surface_finish (pso.ps);
   cairo_surface_destroy (pso.ps);
+  hnj_trace_end (&draw_stage, t0, NULL, 0);
+
+  hnj_trace_close ();
+  if (stats)
+    hnj_trace_print_stats (stderr);
 
   FT_Done_Face (pso.face);
 
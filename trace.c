@@ -0,0 +1,399 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+/* Stage timing and Chrome trace output. See trace.h. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <time.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "trace.h"
+
+#define TRACE_BUFFER_SIZE 256
+
+typedef struct _TraceEvent TraceEvent;
+typedef struct _TraceBuffer TraceBuffer;
+
+/* A span or, if arg_name is TRACE_ADD, time added with
+   hnj_trace_add. */
+struct _TraceEvent {
+  HnjTraceStage *stage;
+  long long t0;
+  long long ns;
+  const char *arg_name;
+  long arg;
+};
+
+static const char trace_add_arg[] = "";
+#define TRACE_ADD trace_add_arg
+
+/* The events of a thread not yet counted or written out. Each thread
+   fills its own buffer without taking the global lock, and takes it
+   only to flush a whole buffer at once. */
+struct _TraceBuffer {
+  int tid;
+  int n_events;
+  TraceEvent events[TRACE_BUFFER_SIZE];
+  TraceBuffer *next;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t lock;
+#endif
+};
+
+static volatile int trace_enabled;
+static FILE *trace_file;
+static int trace_n_events;
+static long long trace_t0;
+static HnjTraceStage *trace_stages;
+static HnjTraceStage **trace_stages_tail = &trace_stages;
+static TraceBuffer *trace_buffers;
+
+/* Locks are taken in the order trace_buffers_lock, the lock of a
+   buffer, trace_lock. */
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t trace_buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t trace_env_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_buffer_key;
+static int trace_n_threads;
+#define TRACE_LOCK() pthread_mutex_lock (&trace_lock)
+#define TRACE_UNLOCK() pthread_mutex_unlock (&trace_lock)
+#define BUFFERS_LOCK() pthread_mutex_lock (&trace_buffers_lock)
+#define BUFFERS_UNLOCK() pthread_mutex_unlock (&trace_buffers_lock)
+#define BUFFER_LOCK(buf) pthread_mutex_lock (&(buf)->lock)
+#define BUFFER_UNLOCK(buf) pthread_mutex_unlock (&(buf)->lock)
+#else
+static int trace_env_checked;
+static TraceBuffer trace_buffer_1;
+#define TRACE_LOCK()
+#define TRACE_UNLOCK()
+#define BUFFERS_LOCK()
+#define BUFFERS_UNLOCK()
+#define BUFFER_LOCK(buf)
+#define BUFFER_UNLOCK(buf)
+#endif
+
+static long long
+trace_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Add a call of ns to stage. Call with the lock held. */
+static void
+trace_count (HnjTraceStage *stage, long long ns)
+{
+  if (!stage->registered)
+    {
+      stage->registered = 1;
+      stage->next = NULL;
+      *trace_stages_tail = stage;
+      trace_stages_tail = &stage->next;
+    }
+  stage->n_calls++;
+  stage->total_ns += ns;
+  if (ns > stage->max_ns)
+    stage->max_ns = ns;
+}
+
+/* Count event, and write it to the trace file if it is a span. Call
+   with the lock held. */
+static void
+trace_emit (const TraceEvent *event, int tid)
+{
+  trace_count (event->stage, event->ns);
+  if (trace_file == NULL || event->arg_name == TRACE_ADD)
+    return;
+  fprintf (trace_file,
+	   "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+	   "\"ts\":%.3f,\"dur\":%.3f",
+	   trace_n_events++ ? "," : "", event->stage->name, tid,
+	   (event->t0 - trace_t0) * 1e-3, event->ns * 1e-3);
+  if (event->arg_name)
+    fprintf (trace_file, ",\"args\":{\"%s\":%ld}", event->arg_name,
+	     event->arg);
+  fputc ('}', trace_file);
+}
+
+/* Count and write out the events in buf. Call with the lock of buf
+   held. */
+static void
+trace_flush (TraceBuffer *buf)
+{
+  int i;
+
+  if (buf->n_events == 0)
+    return;
+  TRACE_LOCK ();
+  for (i = 0; i < buf->n_events; i++)
+    trace_emit (&buf->events[i], buf->tid);
+  TRACE_UNLOCK ();
+  buf->n_events = 0;
+}
+
+/* Flush the buffers of all threads. */
+static void
+trace_flush_all (void)
+{
+  TraceBuffer *buf;
+
+  BUFFERS_LOCK ();
+  for (buf = trace_buffers; buf; buf = buf->next)
+    {
+      BUFFER_LOCK (buf);
+      trace_flush (buf);
+      BUFFER_UNLOCK (buf);
+    }
+  BUFFERS_UNLOCK ();
+}
+
+#ifdef HAVE_PTHREAD
+/* Flush and free the buffer of a thread that is exiting. */
+static void
+trace_buffer_free (void *data)
+{
+  TraceBuffer *buf = data;
+  TraceBuffer **p;
+
+  BUFFERS_LOCK ();
+  for (p = &trace_buffers; *p != buf; p = &(*p)->next)
+    ;
+  *p = buf->next;
+  BUFFERS_UNLOCK ();
+  BUFFER_LOCK (buf);
+  trace_flush (buf);
+  BUFFER_UNLOCK (buf);
+  pthread_mutex_destroy (&buf->lock);
+  free (buf);
+}
+#endif
+
+/* The buffer of the calling thread, or NULL if there's no memory for
+   one. */
+static TraceBuffer *
+trace_buffer (void)
+{
+#ifdef HAVE_PTHREAD
+  TraceBuffer *buf = pthread_getspecific (trace_buffer_key);
+
+  if (buf == NULL)
+    {
+      buf = malloc (sizeof (TraceBuffer));
+      if (buf == NULL)
+	return NULL;
+      buf->n_events = 0;
+      pthread_mutex_init (&buf->lock, NULL);
+      BUFFERS_LOCK ();
+      buf->tid = ++trace_n_threads;
+      buf->next = trace_buffers;
+      trace_buffers = buf;
+      BUFFERS_UNLOCK ();
+      pthread_setspecific (trace_buffer_key, buf);
+    }
+  return buf;
+#else
+  return &trace_buffer_1;
+#endif
+}
+
+/* Queue event in the buffer of the calling thread, flushing it if it
+   is full. */
+static void
+trace_record (const TraceEvent *event)
+{
+  TraceBuffer *buf = trace_buffer ();
+
+  if (buf == NULL)
+    {
+      TRACE_LOCK ();
+      trace_emit (event, 0);
+      TRACE_UNLOCK ();
+      return;
+    }
+  BUFFER_LOCK (buf);
+  buf->events[buf->n_events++] = *event;
+  if (buf->n_events == TRACE_BUFFER_SIZE)
+    trace_flush (buf);
+  BUFFER_UNLOCK (buf);
+}
+
+static int trace_open (const char *filename);
+
+static void
+trace_check_env (void)
+{
+  const char *filename = getenv ("LIBJUSTIFY_TRACE");
+
+#ifdef HAVE_PTHREAD
+  pthread_key_create (&trace_buffer_key, trace_buffer_free);
+#else
+  trace_buffer_1.tid = 1;
+  trace_buffers = &trace_buffer_1;
+#endif
+  trace_t0 = trace_now ();
+  if (filename && *filename && trace_open (filename) == 0)
+    atexit (hnj_trace_close);
+}
+
+static void
+trace_init (void)
+{
+#ifdef HAVE_PTHREAD
+  pthread_once (&trace_env_once, trace_check_env);
+#else
+  if (!trace_env_checked)
+    {
+      trace_env_checked = 1;
+      trace_check_env ();
+    }
+#endif
+}
+
+void
+hnj_trace_enable (int enable)
+{
+  trace_init ();
+  trace_enabled = enable;
+}
+
+int
+hnj_trace_is_enabled (void)
+{
+  trace_init ();
+  return trace_enabled;
+}
+
+static int
+trace_open (const char *filename)
+{
+  FILE *file;
+
+  file = fopen (filename, "w");
+  if (file == NULL)
+    return -1;
+  hnj_trace_close ();
+  TRACE_LOCK ();
+  trace_file = file;
+  trace_n_events = 0;
+  fputs ("{\"traceEvents\":[", file);
+  trace_enabled = 1;
+  TRACE_UNLOCK ();
+  return 0;
+}
+
+int
+hnj_trace_open (const char *filename)
+{
+  trace_init ();
+  return trace_open (filename);
+}
+
+void
+hnj_trace_close (void)
+{
+  trace_flush_all ();
+  TRACE_LOCK ();
+  if (trace_file)
+    {
+      fputs ("\n]}\n", trace_file);
+      fclose (trace_file);
+      trace_file = NULL;
+    }
+  TRACE_UNLOCK ();
+}
+
+long long
+hnj_trace_begin (void)
+{
+  if (!hnj_trace_is_enabled ())
+    return 0;
+  return trace_now ();
+}
+
+void
+hnj_trace_end (HnjTraceStage *stage, long long t0,
+	       const char *arg_name, long arg)
+{
+  TraceEvent event;
+
+  if (t0 == 0)
+    return;
+  event.stage = stage;
+  event.t0 = t0;
+  event.ns = trace_now () - t0;
+  event.arg_name = arg_name;
+  event.arg = arg;
+  trace_record (&event);
+}
+
+void
+hnj_trace_add (HnjTraceStage *stage, long long ns)
+{
+  TraceEvent event;
+
+  if (!trace_enabled)
+    return;
+  event.stage = stage;
+  event.t0 = 0;
+  event.ns = ns;
+  event.arg_name = TRACE_ADD;
+  event.arg = 0;
+  trace_record (&event);
+}
+
+void
+hnj_trace_print_stats (FILE *file)
+{
+  HnjTraceStage *stage;
+
+  trace_flush_all ();
+  TRACE_LOCK ();
+  fprintf (file, "%-12s %8s %12s %10s %10s\n",
+	   "stage", "calls", "total ms", "mean us", "max us");
+  for (stage = trace_stages; stage; stage = stage->next)
+    fprintf (file, "%-12s %8ld %12.3f %10.2f %10.2f\n",
+	     stage->name, stage->n_calls, stage->total_ns * 1e-6,
+	     stage->n_calls ? stage->total_ns * 1e-3 / stage->n_calls : 0,
+	     stage->max_ns * 1e-3);
+  TRACE_UNLOCK ();
+}
@@ -0,0 +1,111 @@
+/* LibHnj is dual licensed under LGPL and MPL. Boilerplate for both
+ * licenses follows.
+ */
+
+/* LibHnj - a library for high quality hyphenation and justification
+ * Copyright (C) 1998 Raph Levien
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the 
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330, 
+ * Boston, MA  02111-1307  USA.
+*/
+
+/*
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "MPL"); you may not use this file except in
+ * compliance with the MPL.  You may obtain a copy of the MPL at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the MPL is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTY OF ANY KIND, either express or implied. See the MPL
+ * for the specific language governing rights and limitations under the
+ * MPL.
+ *
+ */
+#ifndef __HNJ_TRACE_H__
+#define __HNJ_TRACE_H__
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _HnjTraceStage HnjTraceStage;
+
+/* Timing of the stages of setting text.
+
+   A stage is a named, statically allocated counter. Each timed span
+   of a stage adds to its call count, total and maximum time, and, if
+   a trace file is open, writes a complete ("X") event to it in the
+   Chrome trace event format, which chrome://tracing and Perfetto can
+   load. The justifiers time themselves as the stages "hq_just" and
+   "hs_just".
+
+   Timing is off until hnj_trace_enable or hnj_trace_open is called,
+   or the LIBJUSTIFY_TRACE environment variable names a trace file.
+   While it is off, a span costs a test of a global flag. While it is
+   on, it costs two reads of the clock; spans are buffered per thread
+   and counted and written out in batches, when a thread's buffer
+   fills, the thread exits, or the statistics are printed or the trace
+   file closed. Stages declared with HNJ_TRACE_STAGE are registered on
+   first use. */
+struct _HnjTraceStage {
+  const char *name;
+  long n_calls;
+  long long total_ns;
+  long long max_ns;
+  HnjTraceStage *next;
+  int registered;
+};
+
+#define HNJ_TRACE_STAGE(var, name) \
+  static HnjTraceStage var = { name, 0, 0, 0, NULL, 0 }
+
+/* Start or stop collecting the statistics, without writing a trace
+   file. */
+void hnj_trace_enable (int enable);
+
+/* Nonzero if spans are being timed. */
+int hnj_trace_is_enabled (void);
+
+/* Start writing trace events to filename, and collecting the
+   statistics. Returns 0 on success. */
+int hnj_trace_open (const char *filename);
+
+/* Finish and close the trace file. */
+void hnj_trace_close (void);
+
+/* Start a span, returning its start time in nanoseconds, or 0 if
+   timing is off. */
+long long hnj_trace_begin (void);
+
+/* End a span of stage started at t0. If arg_name is not NULL, the
+   trace event gets arg_name = arg as its argument. Does nothing if
+   t0 is 0. */
+void hnj_trace_end (HnjTraceStage *stage, long long t0,
+		    const char *arg_name, long arg);
+
+/* Add ns nanoseconds to the statistics of stage as one call, without
+   a trace event, for time summed over many small pieces. */
+void hnj_trace_add (HnjTraceStage *stage, long long ns);
+
+/* Print the statistics of every stage used so far to file. */
+void hnj_trace_print_stats (FILE *file);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __HNJ_TRACE_H__ */